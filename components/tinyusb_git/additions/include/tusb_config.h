@@ -88,13 +88,27 @@ extern "C" {
 
 // Have a look into audio_device.h for all configurations
 
+// Channel count and sample format come from the application's "WAR Audio" menu
+#ifndef CONFIG_AUDIO_CHANNELS
+#   define CONFIG_AUDIO_CHANNELS 1
+#endif
+
+#if CONFIG_AUDIO_CHANNELS == 2
+#define CFG_TUD_AUDIO_FUNC_1_DESC_LEN                               (TUD_AUDIO_MIC_ONE_CH_DESC_LEN - TUD_AUDIO_DESC_FEATURE_UNIT_ONE_CHANNEL_LEN + TUD_AUDIO_DESC_FEATURE_UNIT_TWO_CHANNEL_LEN)
+#else
 #define CFG_TUD_AUDIO_FUNC_1_DESC_LEN                               TUD_AUDIO_MIC_ONE_CH_DESC_LEN
+#endif
 
 #define CFG_TUD_AUDIO_FUNC_1_MAX_SAMPLE_RATE                        48000     // 24bit/96kHz is the best quality for full-speed, high-speed is needed beyond this
-#define CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX                          1         // Driver gets this info from the descriptors - we define it here to use it to setup the descriptors and to do calculations with it below - be aware: for different number of channels you need another descriptor!
+#define CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX                          CONFIG_AUDIO_CHANNELS         // Driver gets this info from the descriptors - we define it here to use it to setup the descriptors and to do calculations with it below - be aware: for different number of channels you need another descriptor!
 
+#ifdef CONFIG_AUDIO_24BIT
+#define CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX                  4                                       // 24 bits left justified in 32
+#define CFG_TUD_AUDIO_FUNC_1_FORMAT_1_RESOLUTION_TX                 24
+#else
 #define CFG_TUD_AUDIO_FUNC_1_N_BYTES_PER_SAMPLE_TX                  2                                       // Driver gets this info from the descriptors - we define it here to use it to setup the descriptors and to do calculations with it below
 #define CFG_TUD_AUDIO_FUNC_1_FORMAT_1_RESOLUTION_TX                 16
+#endif
 
 #define CFG_TUD_AUDIO_ENABLE_EP_IN                                  1
 
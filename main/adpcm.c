@@ -0,0 +1,110 @@
+#include "adpcm.h"
+#include "audio_format.h"
+
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static inline int32_t adpcm_clamp16(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+// Applies one code to the state, shared by encoder and decoder so they
+// track each other exactly
+static inline void adpcm_step(adpcm_state_t *state, uint8_t code)
+{
+    int32_t step = step_table[state->index];
+    int32_t diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    state->predictor = adpcm_clamp16(code & 8 ? state->predictor - diff : state->predictor + diff);
+
+    int32_t index = state->index + index_table[code];
+    state->index = index < 0 ? 0 : (index > 88 ? 88 : index);
+}
+
+static inline uint8_t adpcm_quantise(const adpcm_state_t *state, int16_t sample)
+{
+    int32_t step = step_table[state->index];
+    int32_t diff = sample - state->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step)
+        code |= 1;
+    return code;
+}
+
+void adpcm_init(adpcm_state_t *state)
+{
+    state->predictor = 0;
+    state->index = 0;
+}
+
+size_t adpcm_encode(adpcm_state_t *state, const int16_t *in, size_t n, uint8_t *out)
+{
+    out[0] = (uint16_t)state->predictor & 0xff;
+    out[1] = (uint16_t)state->predictor >> 8;
+    out[2] = state->index;
+    out[3] = 0;
+
+    uint8_t *p = out + ADPCM_HEADER_LEN;
+    for (size_t i = 0; i < n; i += 2) {
+        uint8_t lo = adpcm_quantise(state, in[i]);
+        adpcm_step(state, lo);
+        uint8_t hi = 0;
+        if (i + 1 < n) {
+            hi = adpcm_quantise(state, in[i + 1]);
+            adpcm_step(state, hi);
+        }
+        *p++ = lo | hi << 4;
+    }
+    return p - out;
+}
+
+AUDIO_HOT size_t adpcm_decode(const uint8_t *in, size_t len, int16_t *out)
+{
+    if (len < ADPCM_HEADER_LEN || in[2] > 88)
+        return 0;
+
+    adpcm_state_t state = {
+        .predictor = (int16_t)(in[0] | in[1] << 8),
+        .index = in[2],
+    };
+    int16_t *o = out;
+    for (size_t i = ADPCM_HEADER_LEN; i < len; i++) {
+        adpcm_step(&state, in[i] & 0x0f);
+        *o++ = state.predictor;
+        adpcm_step(&state, in[i] >> 4);
+        *o++ = state.predictor;
+    }
+    return o - out;
+}
@@ -0,0 +1,39 @@
+#ifndef __ADPCM_H__
+#define __ADPCM_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADPCM_HEADER_LEN            4           // Predictor (int16 LE), step index, reserved
+#define ADPCM_ENCODED_LEN(samples)  (ADPCM_HEADER_LEN + ((samples) + 1) / 2)
+#define ADPCM_DECODED_LEN(bytes)    (((bytes) - ADPCM_HEADER_LEN) * 2)
+
+/*
+ * IMA ADPCM, 4 bits per sample. Every block starts with the coder state it
+ * was encoded from, so blocks decode independently and a lost packet does
+ * not desynchronise the ones after it. Nibbles are packed low first.
+ */
+typedef struct {
+    int16_t predictor;
+    uint8_t index;                              // Into the step size table
+} adpcm_state_t;
+
+void adpcm_init(adpcm_state_t* state);
+
+// Encodes n samples into ADPCM_ENCODED_LEN(n) bytes of out, carrying the
+// state over from the previous block. Returns the bytes written.
+size_t adpcm_encode(adpcm_state_t* state, const int16_t* in, size_t n, uint8_t* out);
+
+// Decodes a whole block into ADPCM_DECODED_LEN(len) samples. Returns the
+// samples written, 0 if the block is malformed.
+size_t adpcm_decode(const uint8_t* in, size_t len, int16_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ADPCM_H__
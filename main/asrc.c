@@ -0,0 +1,156 @@
+#include "asrc.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define ASRC_HALF               (ASRC_TAPS / 2)
+#define ASRC_CUTOFF             0.45f           // Of the sample rate, the passband runs to 21.6 kHz at 48 kHz
+#define ASRC_Q32_PER_PPM        4295            // 2^32 / 10^6
+
+// Fill controller, see asrc_steer(). Critically damped with a time
+// constant of about 4 s at 48 kHz.
+#define ASRC_KP                 168             // Q32 delta per Q8 frame of error, 10 ppm per frame
+#define ASRC_KI                 27              // Q48 delta per Q8 frame of error per frame
+#define ASRC_AVG_SHIFT          7               // Error averaged over 128 calls
+
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int64_t asrc_acc_t;
+#define ASRC_SAMPLE_MAX         INT32_MAX
+#define ASRC_SAMPLE_MIN         INT32_MIN
+#else
+typedef int32_t asrc_acc_t;
+#define ASRC_SAMPLE_MAX         INT16_MAX
+#define ASRC_SAMPLE_MIN         INT16_MIN
+#endif
+
+// Phase p holds the taps for an output p / ASRC_PHASES of a frame past the
+// frame the window is centered on; the extra last phase is the first one
+// moved along a frame, so interpolation never wraps
+static int16_t asrc_coefs[ASRC_PHASES + 1][ASRC_TAPS];
+static bool asrc_coefs_ready;
+
+static void asrc_make_coefs()
+{
+    for (int p = 0; p <= ASRC_PHASES; p++) {
+        float taps[ASRC_TAPS];
+        float sum = 0;
+        for (int k = 0; k < ASRC_TAPS; k++) {
+            float t = k - (ASRC_HALF - 1) - (float)p / ASRC_PHASES;
+            float x = 2 * ASRC_CUTOFF * t;
+            float sinc = t == 0 ? 1 : sinf(M_PI * x) / (M_PI * x);
+            float w = 2 * M_PI * t / ASRC_TAPS;
+            float blackman = 0.42f + 0.5f * cosf(w) + 0.08f * cosf(2 * w);
+            taps[k] = sinc * blackman;
+            sum += taps[k];
+        }
+        // Exactly unity gain at DC for every phase, rounding included, or
+        // the level would ripple as the position sweeps through the phases
+        int32_t rounded = 0;
+        for (int k = 0; k < ASRC_TAPS; k++) {
+            asrc_coefs[p][k] = lrintf(taps[k] / sum * (1 << ASRC_COEF_SHIFT));
+            rounded += asrc_coefs[p][k];
+        }
+        int centre = ASRC_HALF - 1 + (p >= ASRC_PHASES / 2);
+        asrc_coefs[p][centre] += (1 << ASRC_COEF_SHIFT) - rounded;
+    }
+    asrc_coefs_ready = true;
+}
+
+void asrc_init(asrc_t *asrc, size_t target_fill)
+{
+    if (!asrc_coefs_ready)
+        asrc_make_coefs();
+
+    memset(asrc, 0, sizeof(asrc_t));
+    // Silence as history, as if the last call had moved on one frame
+    asrc->kept = ASRC_TAPS - 1;
+    asrc->target = target_fill;
+}
+
+AUDIO_HOT static uint64_t asrc_step(const asrc_t *asrc)
+{
+    return (uint64_t)((int64_t)1 << 32) + asrc->delta;
+}
+
+AUDIO_HOT size_t asrc_input_frames(const asrc_t *asrc, size_t out_frames)
+{
+    if (out_frames == 0)
+        return 0;
+    // Frames the position moves on before the last output, plus the window
+    // that output needs, minus what is still held from the last call
+    size_t moved = ((uint64_t)asrc->frac + (out_frames - 1) * asrc_step(asrc)) >> 32;
+    return ASRC_TAPS + moved - asrc->kept;
+}
+
+AUDIO_HOT static audio_sample_t asrc_saturate(asrc_acc_t acc)
+{
+    acc = (acc + (1 << (ASRC_COEF_SHIFT - 1))) >> ASRC_COEF_SHIFT;
+    if (acc > ASRC_SAMPLE_MAX)
+        return ASRC_SAMPLE_MAX;
+    if (acc < ASRC_SAMPLE_MIN)
+        return ASRC_SAMPLE_MIN;
+    return acc;
+}
+
+AUDIO_HOT void asrc_process(asrc_t *asrc, const audio_sample_t *in, audio_sample_t *out, size_t out_frames)
+{
+    size_t in_frames = asrc_input_frames(asrc, out_frames);
+    memcpy(&asrc->buf[asrc->kept * AUDIO_CHANNELS], in, in_frames * AUDIO_CHANNELS * sizeof(audio_sample_t));
+    size_t total = asrc->kept + in_frames;
+
+    uint64_t step = asrc_step(asrc);
+    uint32_t frac = asrc->frac;
+    size_t pos = 0;                             // First frame of the window
+    for (size_t j = 0; j < out_frames; j++) {
+        uint32_t p = frac >> (32 - ASRC_PHASE_BITS);
+        int32_t sub = (frac >> (32 - ASRC_PHASE_BITS - 15)) & 0x7fff;
+        const int16_t *h0 = asrc_coefs[p];
+        const int16_t *h1 = asrc_coefs[p + 1];
+        int32_t c[ASRC_TAPS];
+        for (int k = 0; k < ASRC_TAPS; k++)
+            c[k] = h0[k] + (((h1[k] - h0[k]) * sub + (1 << 14)) >> 15);
+
+        const audio_sample_t *x = &asrc->buf[pos * AUDIO_CHANNELS];
+        for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+            asrc_acc_t acc = 0;
+            for (int k = 0; k < ASRC_TAPS; k++)
+                acc += (asrc_acc_t)c[k] * x[k * AUDIO_CHANNELS + ch];
+            *out++ = asrc_saturate(acc);
+        }
+
+        uint64_t next = frac + step;
+        pos += next >> 32;
+        frac = next;
+    }
+    asrc->frac = frac;
+
+    // Keep the next output's window
+    asrc->kept = total - pos;
+    memmove(asrc->buf, &asrc->buf[pos * AUDIO_CHANNELS], asrc->kept * AUDIO_CHANNELS * sizeof(audio_sample_t));
+}
+
+AUDIO_HOT void asrc_steer(asrc_t *asrc, size_t fill, size_t out_frames)
+{
+    const int64_t limit = (int64_t)ASRC_MAX_PPM * ASRC_Q32_PER_PPM;
+    int32_t error = ((int32_t)fill - asrc->target) * 256;
+    asrc->error_avg += (error - asrc->error_avg) / (1 << ASRC_AVG_SHIFT);
+
+    // A full ring means the sink is slow, so take input faster
+    asrc->integral += (int64_t)asrc->error_avg * ASRC_KI * (int64_t)out_frames;
+    if (asrc->integral > limit << 16)
+        asrc->integral = limit << 16;
+    if (asrc->integral < -(limit << 16))
+        asrc->integral = -(limit << 16);
+
+    int64_t delta = (int64_t)asrc->error_avg * ASRC_KP + (asrc->integral >> 16);
+    if (delta > limit)
+        delta = limit;
+    if (delta < -limit)
+        delta = -limit;
+    asrc->delta = delta;
+}
+
+int32_t asrc_ppm(const asrc_t *asrc)
+{
+    return (int64_t)asrc->delta * 1000000 >> 32;
+}
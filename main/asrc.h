@@ -0,0 +1,68 @@
+#ifndef __ASRC_H__
+#define __ASRC_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "audio_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ASRC_TAPS               16              // Per phase, also the delay in frames
+#define ASRC_PHASE_BITS         6
+#define ASRC_PHASES             (1 << ASRC_PHASE_BITS)
+#define ASRC_COEF_SHIFT         14              // Q14 coefficients leave headroom in the 32-bit sum
+#define ASRC_MAX_FRAMES         96              // Output frames per call
+#define ASRC_MAX_IN             (ASRC_MAX_FRAMES + 2)
+#define ASRC_MAX_PPM            1000            // Correction the fill controller may apply
+
+/*
+ * Adaptive asynchronous sample rate converter between the network ring and
+ * a sink running off its own clock. A 16 tap windowed sinc is stored in
+ * ASRC_PHASES phases; each output frame linearly interpolates the
+ * coefficients of the two phases around its fractional input position and
+ * filters every channel with them. All fixed point.
+ *
+ * The ratio is 1 + delta, delta in Q32 input frames per output frame, and
+ * is steered by a PI controller on the fill level of the ring the input
+ * comes from: a ring filling up means the sink runs slow, so input is
+ * consumed faster. The fill is averaged first since network writes arrive
+ * in bursts of a packet. +-200 ppm between the clocks settles with the
+ * fill back on target and no jump in the output.
+ *
+ * Call asrc_input_frames, read exactly that many frames, then
+ * asrc_process. Not thread safe, one instance per sink.
+ */
+typedef struct {
+    audio_sample_t buf[(ASRC_TAPS + ASRC_MAX_IN) * AUDIO_CHANNELS];
+    size_t kept;                                // Frames at the start of buf from the previous call
+    uint32_t frac;                              // Q32 position between input frames
+    int32_t delta;                              // Q32 ratio - 1
+
+    // Fill controller
+    int32_t target;                             // Frames
+    int32_t error_avg;                          // Frames, Q8
+    int64_t integral;                           // Q32
+} asrc_t;
+
+void asrc_init(asrc_t* asrc, size_t target_fill);
+
+// Frames asrc_process will consume to produce out_frames
+size_t asrc_input_frames(const asrc_t* asrc, size_t out_frames);
+
+// Resamples asrc_input_frames(out_frames) frames of in into out
+void asrc_process(asrc_t* asrc, const audio_sample_t* in, audio_sample_t* out, size_t out_frames);
+
+// Adjusts the ratio from the fill of the input ring, in frames, once per
+// call of out_frames
+void asrc_steer(asrc_t* asrc, size_t fill, size_t out_frames);
+
+// Current correction, parts per million
+int32_t asrc_ppm(const asrc_t* asrc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ASRC_H__
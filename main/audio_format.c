@@ -0,0 +1,38 @@
+#include "audio_format.h"
+#include <string.h>
+
+// Reads one sample as a left justified 32-bit value
+static inline int32_t audio_load(const uint8_t *in, uint8_t bytes, size_t i)
+{
+    if (bytes == 4) {
+        int32_t s;
+        memcpy(&s, in + i * 4, sizeof(s));
+        return s;
+    }
+    int16_t s;
+    memcpy(&s, in + i * 2, sizeof(s));
+    return (int32_t)s * 65536;
+}
+
+AUDIO_HOT size_t audio_convert(const void *in, uint8_t bytes, uint8_t channels, size_t frames, audio_sample_t *out)
+{
+    const uint8_t *src = (const uint8_t *)in;
+
+    if (channels == AUDIO_CHANNELS && bytes == sizeof(audio_sample_t)) {
+        memcpy(out, src, frames * AUDIO_CHANNELS * sizeof(audio_sample_t));
+        return frames * AUDIO_CHANNELS;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t l = audio_load(src, bytes, i * channels);
+        int32_t r = channels == 2 ? audio_load(src, bytes, i * channels + 1) : l;
+#if AUDIO_CHANNELS == 2
+        out[i * 2] = l >> (16 - AUDIO_SAMPLE_SHIFT);
+        out[i * 2 + 1] = r >> (16 - AUDIO_SAMPLE_SHIFT);
+#else
+        out[i] = ((l >> 1) + (r >> 1)) >> (16 - AUDIO_SAMPLE_SHIFT);
+#endif
+    }
+
+    return frames * AUDIO_CHANNELS;
+}
@@ -0,0 +1,48 @@
+#ifndef __AUDIO_FORMAT_H__
+#define __AUDIO_FORMAT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "war_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sink sample type, channels interleaved
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int32_t audio_sample_t;
+#define AUDIO_SAMPLE_SHIFT      16              // From 16-bit samples
+#else
+typedef int16_t audio_sample_t;
+#define AUDIO_SAMPLE_SHIFT      0
+#endif
+
+// Top 16 bits of a sink sample
+#define AUDIO_SAMPLE_TO_I16(s)  ((int16_t)((s) >> AUDIO_SAMPLE_SHIFT))
+
+#if AUDIO_CHANNELS < 1 || AUDIO_CHANNELS > 2
+#error "AUDIO_CHANNELS must be 1 or 2"
+#endif
+
+/*
+ * Tags a function on the per sample or per packet path. The ESP32-S2 has no
+ * FPU, so float there is a libgcc call per operation. GCC places hot
+ * functions in .text.hot.* and the build fails if one of those references a
+ * soft float helper, see check_hot_float.cmake.
+ */
+#define AUDIO_HOT               __attribute__((hot))
+
+/*
+ * Converts frames of interleaved 16-bit (bytes 2) or 24-in-32-bit (bytes 4)
+ * samples with 1 or 2 channels to the sink format. Mono is copied to both
+ * sink channels, stereo is averaged down to a mono sink. Returns the number
+ * of samples written, frames * AUDIO_CHANNELS.
+ */
+size_t audio_convert(const void* in, uint8_t bytes, uint8_t channels, size_t frames, audio_sample_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __AUDIO_FORMAT_H__
@@ -0,0 +1,170 @@
+#include "channel.h"
+#include <string.h>
+
+#define CHANNEL_SNR_GOOD        30      // dB, below this every dB costs
+#define CHANNEL_NETWORKS_MAX    10      // Networks counted towards congestion
+
+static uint32_t channel_link_penalty(const channel_link_sample_t *sample)
+{
+    uint32_t penalty = sample->loss_permille * 4 + sample->retry_permille * 2;
+    if (sample->rssi != 0 && sample->noise != 0) {
+        int snr = sample->rssi - sample->noise;
+        if (snr < CHANNEL_SNR_GOOD)
+            penalty += (CHANNEL_SNR_GOOD - snr) * 10;
+    }
+    return penalty < CHANNEL_SCORE_MAX ? penalty : CHANNEL_SCORE_MAX;
+}
+
+static uint32_t channel_busy_penalty(const channel_probe_t *probe)
+{
+    uint32_t networks = probe->networks < CHANNEL_NETWORKS_MAX ? probe->networks : CHANNEL_NETWORKS_MAX;
+    uint32_t penalty = networks * 25;
+    // A strong neighbour hurts more than several distant ones
+    if (probe->strongest != 0 && probe->strongest > -90)
+        penalty += (probe->strongest + 90) * 3;
+    return penalty < CHANNEL_SCORE_MAX ? penalty : CHANNEL_SCORE_MAX;
+}
+
+static uint8_t channel_next(uint16_t mask, uint8_t from)
+{
+    for (int i = 1; i <= CHANNEL_MAX; i++) {
+        uint8_t channel = (from + i - 1) % CHANNEL_MAX + 1;
+        if (mask & (1 << channel))
+            return channel;
+    }
+    return from;
+}
+
+void channel_ctrl_init(channel_ctrl_t *ctrl, uint8_t current, uint16_t mask, int64_t now_ms)
+{
+    memset(ctrl, 0, sizeof(channel_ctrl_t));
+    for (int i = 0; i <= CHANNEL_MAX; i++)
+        ctrl->channels[i].probed_ms = -1;
+    ctrl->mask = mask | (1 << current);
+    ctrl->current = current;
+    ctrl->last_probe = current;
+    ctrl->switched_ms = now_ms;
+}
+
+void channel_ctrl_link(channel_ctrl_t *ctrl, const channel_link_sample_t *sample)
+{
+    channel_state_t *state = &ctrl->channels[ctrl->current];
+    state->link_penalty = (state->link_penalty * 3 + channel_link_penalty(sample)) / 4;
+
+    if (channel_ctrl_score(ctrl, ctrl->current) < CHANNEL_SCORE_DEGRADED) {
+        ctrl->degraded++;
+    } else {
+        ctrl->degraded = 0;
+        ctrl->round = 0;
+    }
+}
+
+void channel_ctrl_probed(channel_ctrl_t *ctrl, uint8_t channel, const channel_probe_t *probe, int64_t now_ms)
+{
+    if (channel < 1 || channel > CHANNEL_MAX)
+        return;
+
+    channel_state_t *state = &ctrl->channels[channel];
+    uint32_t penalty = channel_busy_penalty(probe);
+    state->busy_penalty = state->probed_ms < 0 ? penalty : (state->busy_penalty + penalty) / 2;
+    state->probed_ms = now_ms;
+    // What drove us off a channel fades as it gets probed again
+    if (channel != ctrl->current)
+        state->link_penalty /= 2;
+    ctrl->stats.probes++;
+}
+
+uint32_t channel_ctrl_score(const channel_ctrl_t *ctrl, uint8_t channel)
+{
+    const channel_state_t *state = &ctrl->channels[channel];
+    uint32_t penalty = state->link_penalty + state->busy_penalty;
+    return penalty < CHANNEL_SCORE_MAX ? CHANNEL_SCORE_MAX - penalty : 0;
+}
+
+uint8_t channel_ctrl_next_probe(channel_ctrl_t *ctrl, int64_t now_ms)
+{
+    if (ctrl->degraded < CHANNEL_DEGRADED_SAMPLES || now_ms < ctrl->probe_due_ms)
+        return 0;
+
+    ctrl->last_probe = channel_next(ctrl->mask, ctrl->last_probe);
+    ctrl->probe_due_ms = now_ms + CHANNEL_PROBE_INTERVAL_MS;
+    ctrl->round++;
+    return ctrl->last_probe;
+}
+
+uint8_t channel_ctrl_pick(channel_ctrl_t *ctrl, int64_t now_ms)
+{
+    if (ctrl->degraded < CHANNEL_DEGRADED_SAMPLES || ctrl->round < __builtin_popcount(ctrl->mask) ||
+        now_ms - ctrl->switched_ms < CHANNEL_MIN_DWELL_MS)
+        return 0;
+
+    uint32_t best_score = channel_ctrl_score(ctrl, ctrl->current) + CHANNEL_MIGRATE_MARGIN;
+    uint8_t best = 0;
+    for (uint8_t channel = 1; channel <= CHANNEL_MAX; channel++) {
+        const channel_state_t *state = &ctrl->channels[channel];
+        if (channel == ctrl->current || !(ctrl->mask & (1 << channel)) || state->probed_ms < 0 ||
+            now_ms - state->probed_ms > CHANNEL_PROBE_MAX_AGE_MS)
+            continue;
+        uint32_t score = channel_ctrl_score(ctrl, channel);
+        if (score >= best_score) {
+            best_score = score + 1;
+            best = channel;
+        }
+    }
+    return best;
+}
+
+void channel_ctrl_switched(channel_ctrl_t *ctrl, uint8_t channel, int64_t now_ms)
+{
+    ctrl->current = channel;
+    ctrl->channels[channel].link_penalty = 0;
+    ctrl->degraded = 0;
+    ctrl->round = 0;
+    ctrl->switched_ms = now_ms;
+    ctrl->stats.migrations++;
+}
+
+void channel_follow_init(channel_follow_t *follow, uint8_t current, uint16_t mask, int64_t now_ms)
+{
+    memset(follow, 0, sizeof(channel_follow_t));
+    follow->mask = mask | (1 << current);
+    follow->current = current;
+    follow->heard_ms = now_ms;
+    follow->hop_ms = now_ms;
+}
+
+void channel_follow_announce(channel_follow_t *follow, uint8_t channel, uint32_t switch_seq)
+{
+    if (channel == follow->current || channel < 1 || channel > CHANNEL_MAX)
+        return;
+
+    follow->pending = true;
+    follow->target = channel;
+    follow->switch_seq = switch_seq;
+}
+
+static uint8_t channel_follow_switch(channel_follow_t *follow, uint8_t channel, int64_t now_ms)
+{
+    follow->current = channel;
+    follow->pending = false;
+    follow->hop_ms = now_ms;
+    return channel;
+}
+
+uint8_t channel_follow_packet(channel_follow_t *follow, uint32_t seq, int64_t now_ms)
+{
+    follow->heard_ms = now_ms;
+    if (follow->pending && (int32_t)(seq - (follow->switch_seq - 1)) >= 0)
+        return channel_follow_switch(follow, follow->target, now_ms);
+    return 0;
+}
+
+uint8_t channel_follow_tick(channel_follow_t *follow, int64_t now_ms)
+{
+    int64_t silent = now_ms - follow->heard_ms;
+    if (follow->pending && silent >= CHANNEL_FOLLOW_MS)
+        return channel_follow_switch(follow, follow->target, now_ms);
+    if (silent >= CHANNEL_LOST_MS && now_ms - follow->hop_ms >= CHANNEL_HUNT_DWELL_MS)
+        return channel_follow_switch(follow, channel_next(follow->mask, follow->current), now_ms);
+    return 0;
+}
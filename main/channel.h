@@ -0,0 +1,123 @@
+#ifndef __CHANNEL_H__
+#define __CHANNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHANNEL_MAX                 13
+#define CHANNEL_SCORE_MAX           1000
+#define CHANNEL_SCORE_DEGRADED      700     // Below this the transmitter looks for another channel
+#define CHANNEL_DEGRADED_SAMPLES    4       // Link samples in a row below it before probing starts
+#define CHANNEL_MIGRATE_MARGIN      200     // Lead a candidate needs over the current channel
+#define CHANNEL_MIN_DWELL_MS        30000   // Between migrations
+#define CHANNEL_PROBE_INTERVAL_MS   1000    // Between probes of other channels
+#define CHANNEL_PROBE_MAX_AGE_MS    20000   // Probes older than this are not trusted
+#define CHANNEL_LOST_MS             500     // Receiver silence before it hunts for the transmitter
+#define CHANNEL_HUNT_DWELL_MS       100     // Receiver time on each channel while hunting
+#define CHANNEL_FOLLOW_MS           40      // Receiver silence after an announcement before it switches anyway
+
+/*
+ * Measurements of one channel. A link sample comes from the live stream on
+ * the current channel: loss from receiver feedback, failed or refused sends,
+ * and the RSSI and noise floor the receiver sees. A probe comes from a short
+ * passive scan of any channel: the other networks heard and the strongest.
+ */
+typedef struct {
+    uint32_t loss_permille;
+    uint32_t retry_permille;
+    int8_t rssi;                            // dBm, 0 when unknown
+    int8_t noise;                           // dBm, 0 when unknown
+} channel_link_sample_t;
+
+typedef struct {
+    uint8_t networks;
+    int8_t strongest;                       // dBm, 0 when none
+} channel_probe_t;
+
+typedef struct {
+    uint32_t link_penalty;                  // Smoothed, only measured while on the channel
+    uint32_t busy_penalty;                  // Smoothed, from probes
+    int64_t probed_ms;                      // -1 when never probed
+} channel_state_t;
+
+typedef struct {
+    uint32_t probes;
+    uint32_t migrations;
+} channel_stats_t;
+
+/*
+ * Transmitter side. Scores every channel as CHANNEL_SCORE_MAX minus a link
+ * penalty and a congestion penalty, both integer and smoothed. While the
+ * current channel scores well nothing else happens; once it has been
+ * degraded for CHANNEL_DEGRADED_SAMPLES link samples, other channels are
+ * probed one at a time. After a full round a channel scoring
+ * CHANNEL_MIGRATE_MARGIN better than the current one is picked. Migrations are at least
+ * CHANNEL_MIN_DWELL_MS apart so a noisy environment can not bounce the
+ * link around.
+ */
+typedef struct {
+    channel_state_t channels[CHANNEL_MAX + 1];  // Indexed by channel number
+    uint16_t mask;                          // Bit n set if channel n may be used
+    uint8_t current;
+    uint8_t last_probe;
+    uint32_t degraded;                      // Link samples in a row below CHANNEL_SCORE_DEGRADED
+    uint32_t round;                         // Channels probed since the link degraded
+    int64_t switched_ms;
+    int64_t probe_due_ms;
+    channel_stats_t stats;
+} channel_ctrl_t;
+
+void channel_ctrl_init(channel_ctrl_t* ctrl, uint8_t current, uint16_t mask, int64_t now_ms);
+
+void channel_ctrl_link(channel_ctrl_t* ctrl, const channel_link_sample_t* sample);
+
+void channel_ctrl_probed(channel_ctrl_t* ctrl, uint8_t channel, const channel_probe_t* probe, int64_t now_ms);
+
+uint32_t channel_ctrl_score(const channel_ctrl_t* ctrl, uint8_t channel);
+
+// Next channel to probe, 0 when no probe is due
+uint8_t channel_ctrl_next_probe(channel_ctrl_t* ctrl, int64_t now_ms);
+
+// Channel to migrate to, 0 to stay
+uint8_t channel_ctrl_pick(channel_ctrl_t* ctrl, int64_t now_ms);
+
+// The migration to channel took place
+void channel_ctrl_switched(channel_ctrl_t* ctrl, uint8_t channel, int64_t now_ms);
+
+/*
+ * Receiver side. A transmitter announces that its packets from switch_seq
+ * on go out on another channel. The receiver moves once it has a packet at
+ * or after switch_seq - 1, or after CHANNEL_FOLLOW_MS without any packet
+ * once the announcement is in. A receiver that missed every announcement
+ * hears nothing for CHANNEL_LOST_MS and then hunts through the channels,
+ * CHANNEL_HUNT_DWELL_MS on each, until the transmitter is heard again.
+ */
+typedef struct {
+    uint16_t mask;
+    uint8_t current;
+    bool pending;
+    uint8_t target;
+    uint32_t switch_seq;
+    int64_t heard_ms;                       // Last packet from the transmitter
+    int64_t hop_ms;                         // Last hunting hop
+} channel_follow_t;
+
+void channel_follow_init(channel_follow_t* follow, uint8_t current, uint16_t mask, int64_t now_ms);
+
+void channel_follow_announce(channel_follow_t* follow, uint8_t channel, uint32_t switch_seq);
+
+// A packet with seq arrived. Returns the channel to move to, 0 to stay.
+uint8_t channel_follow_packet(channel_follow_t* follow, uint32_t seq, int64_t now_ms);
+
+// Called periodically. Returns the channel to move to, 0 to stay.
+uint8_t channel_follow_tick(channel_follow_t* follow, int64_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __CHANNEL_H__
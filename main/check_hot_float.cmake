@@ -0,0 +1,51 @@
+# Fails if a function tagged AUDIO_HOT uses float. The ESP32-S2 has no FPU,
+# so any float operation is a call to a libgcc soft float helper, and the
+# hot attribute puts the function in .text.hot.<name> with its literals in
+# .literal.hot.<name>. Any relocation from those sections to a helper is a
+# float operation on the audio path.
+#
+# cmake -DOBJDUMP=<objdump> -DLIBRARY=<archive or object> -P check_hot_float.cmake
+
+if(NOT OBJDUMP OR NOT LIBRARY)
+    message(FATAL_ERROR "check_hot_float: OBJDUMP and LIBRARY are required")
+endif()
+
+execute_process(COMMAND ${OBJDUMP} -r ${LIBRARY}
+    OUTPUT_VARIABLE relocs
+    ERROR_VARIABLE errors
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "check_hot_float: ${OBJDUMP} failed: ${errors}")
+endif()
+
+# Arithmetic, comparison and conversion helpers for float and double
+set(soft_float "__(add|sub|mul|div|neg)[sd]f3|__(eq|ne|lt|le|gt|ge|cmp|unord)[sd]f2|__float(un)?[sd]i[sd]f|__fix(uns)?[sd]f[sd]i|__extendsfdf2|__truncdfsf2")
+
+string(REPLACE "\n" ";" lines "${relocs}")
+set(object "")
+set(function "")
+set(checked FALSE)
+set(found "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^([^ ]+):[ \t]+file format")
+        set(object "${CMAKE_MATCH_1}")
+    elseif(line MATCHES "^RELOCATION RECORDS FOR \\[\\.(text|literal)\\.hot\\.([^]]+)\\]")
+        set(function "${CMAKE_MATCH_2}")
+        set(checked TRUE)
+    elseif(line MATCHES "^RELOCATION RECORDS FOR")
+        set(function "")
+    elseif(function AND line MATCHES "[ \t](${soft_float})([+-]|$)")
+        list(APPEND found "  ${object}: ${function} uses ${CMAKE_MATCH_1}")
+    endif()
+endforeach()
+
+# -O0 ignores -freorder-functions and leaves hot functions in .text.<name>
+if(NOT checked)
+    message(WARNING "check_hot_float: no AUDIO_HOT sections in ${LIBRARY}, float use not checked")
+endif()
+
+if(found)
+    list(REMOVE_DUPLICATES found)
+    string(REPLACE ";" "\n" found "${found}")
+    message(FATAL_ERROR "Float in AUDIO_HOT functions:\n${found}")
+endif()
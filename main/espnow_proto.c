@@ -0,0 +1,67 @@
+#include "espnow_proto.h"
+#include "adpcm.h"
+#include "lossless.h"
+
+_Static_assert(sizeof(espnow_data_t) % 4 == 0, "payload must stay 32-bit aligned");
+
+static int espnow_sample_rate_supported(uint32_t rate)
+{
+    return rate == 44100 || rate == 48000;
+}
+
+espnow_header_check_t espnow_header_check(const uint8_t *data, size_t len)
+{
+    const espnow_data_t *buf = (const espnow_data_t *)data;
+
+    // Other versions are turned away on the first byte
+    if (len < 1)
+        return ESPNOW_HEADER_SHORT;
+    if (buf->version != ESPNOW_VERSION)
+        return ESPNOW_HEADER_VERSION;
+    if (len < sizeof(espnow_data_t))
+        return ESPNOW_HEADER_SHORT;
+    if (buf->type > ESPNOW_PACKET_CHANNEL)
+        return ESPNOW_HEADER_TYPE;
+    if (buf->type == ESPNOW_PACKET_FEEDBACK)
+        return len == sizeof(espnow_data_t) + sizeof(espnow_feedback_t) ? ESPNOW_HEADER_OK
+                                                                         : ESPNOW_HEADER_PAYLOAD_LEN;
+    if (buf->type == ESPNOW_PACKET_CHANNEL)
+        return len == sizeof(espnow_data_t) + sizeof(espnow_channel_switch_t) ? ESPNOW_HEADER_OK
+                                                                               : ESPNOW_HEADER_PAYLOAD_LEN;
+
+    if (buf->codec > ESPNOW_CODEC_LOSSLESS)
+        return ESPNOW_HEADER_CODEC;
+    if (buf->format > ESPNOW_FORMAT_S24_32)
+        return ESPNOW_HEADER_FORMAT;
+    if (buf->channels == 0 || buf->channels > ESPNOW_MAX_CHANNELS)
+        return ESPNOW_HEADER_CHANNELS;
+    // The compressed codecs are mono 16-bit only
+    if (buf->codec != ESPNOW_CODEC_PCM && (buf->format != ESPNOW_FORMAT_S16 || buf->channels != 1))
+        return ESPNOW_HEADER_FORMAT;
+    if (!espnow_sample_rate_supported(buf->sample_rate))
+        return ESPNOW_HEADER_SAMPLE_RATE;
+
+    size_t samples = (size_t)buf->frame_len * buf->channels;
+    if (buf->frame_len == 0 || samples > ESPNOW_MAX_PACKET_SAMPLES)
+        return ESPNOW_HEADER_FRAME_LEN;
+    if (buf->type == ESPNOW_PACKET_PARITY)
+        return ESPNOW_HEADER_OK;
+
+    size_t payload_len = len - sizeof(espnow_data_t);
+    switch (buf->codec) {
+    case ESPNOW_CODEC_PCM:
+        if (payload_len != samples * ESPNOW_FORMAT_BYTES(buf->format))
+            return ESPNOW_HEADER_PAYLOAD_LEN;
+        break;
+    case ESPNOW_CODEC_ADPCM:
+        if (payload_len != ADPCM_ENCODED_LEN(samples))
+            return ESPNOW_HEADER_PAYLOAD_LEN;
+        break;
+    case ESPNOW_CODEC_LOSSLESS:
+        if (payload_len < LOSSLESS_HEADER_LEN || payload_len > LOSSLESS_MAX_LEN(samples))
+            return ESPNOW_HEADER_PAYLOAD_LEN;
+        break;
+    }
+
+    return ESPNOW_HEADER_OK;
+}
@@ -0,0 +1,110 @@
+#ifndef __ESPNOW_PROTO_H__
+#define __ESPNOW_PROTO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESPNOW_VERSION              3
+#define ESPNOW_MAX_CHANNELS         2
+#define ESPNOW_MAX_PACKET_SAMPLES   480             // frame_len * channels, bounds the decode buffer
+
+enum {
+    ESPNOW_PACKET_AUDIO,
+    ESPNOW_PACKET_PARITY,                 //XOR of the previous fec_k audio payloads, header of the first one.
+    ESPNOW_PACKET_FEEDBACK,               //Receiver report, espnow_feedback_t payload, stream fields unused.
+    ESPNOW_PACKET_CHANNEL,                //Channel switch announcement, espnow_channel_switch_t payload, stream fields unused.
+};
+
+enum {
+    ESPNOW_CODEC_PCM,                     //Raw samples in the packet's format.
+    ESPNOW_CODEC_ADPCM,                   //One IMA ADPCM block, 4 bits per sample, mono 16-bit only.
+    ESPNOW_CODEC_LOSSLESS,                //One lossless block, LPC and Rice coded or raw, mono 16-bit only.
+};
+
+enum {
+    ESPNOW_FORMAT_S16,                    //Signed 16-bit samples, channels interleaved.
+    ESPNOW_FORMAT_S24_32,                 //Signed 24-bit samples left justified in 32 bits, channels interleaved.
+};
+
+typedef enum {
+    ESPNOW_HEADER_OK,
+    ESPNOW_HEADER_SHORT,                  //Shorter than the header.
+    ESPNOW_HEADER_VERSION,                //Unknown version, nothing else was looked at.
+    ESPNOW_HEADER_TYPE,
+    ESPNOW_HEADER_CODEC,
+    ESPNOW_HEADER_FORMAT,
+    ESPNOW_HEADER_CHANNELS,
+    ESPNOW_HEADER_SAMPLE_RATE,
+    ESPNOW_HEADER_FRAME_LEN,
+    ESPNOW_HEADER_PAYLOAD_LEN,            //Payload does not match codec and frame_len.
+} espnow_header_check_t;
+
+/*
+ * Every packet describes its own stream, so the receiver configures itself
+ * from the header instead of compile-time constants. The version comes
+ * first so a receiver rejects an incompatible transmitter by looking at one
+ * byte. Multi-byte fields are little endian.
+ */
+typedef struct {
+    uint8_t version;                      //ESPNOW_VERSION.
+    uint8_t type;                         //ESPNOW_PACKET_*.
+    uint8_t codec;                        //ESPNOW_CODEC_* of the payload.
+    uint8_t format;                       //ESPNOW_FORMAT_* of the decoded samples.
+    uint8_t channels;
+    uint8_t fec_k;                        //Audio packets per parity packet, 0 without FEC.
+    uint16_t crc;                         //CRC16 value of ESPNOW data.
+    uint32_t seq_num;                     //Sequence number of ESPNOW data.
+    uint32_t sample_rate;                 //Hz.
+    uint64_t timestamp;                   //Sample position of the payload's first frame.
+    uint16_t frame_len;                   //Samples per channel in the payload.
+    uint8_t copies;                       //Extra copies sent of each audio packet.
+    uint8_t reserved;                     //Keeps the payload 32-bit aligned.
+    uint8_t payload[0];                   //Real payload of ESPNOW data.
+} __attribute__((packed)) espnow_data_t;
+
+/*
+ * Sent by a receiver every ESPNOW_FEEDBACK_MS for each transmitter it hears,
+ * counts cover the time since its previous report. expected counts the
+ * audio packets the transmitter sent over the sequence numbers seen, copies
+ * included, so expected minus received is the loss on the air before FEC
+ * and copies repair it.
+ */
+typedef struct {
+    uint32_t received;                    //Audio packets received, copies included.
+    uint32_t expected;
+    uint32_t lost;                        //Packets still missing at playout.
+    uint32_t late;                        //Packets arriving after their playout deadline.
+    uint32_t reordered;
+    uint8_t source[6];                    //MAC of the transmitter reported on, others ignore the report.
+    int8_t rssi;                          //dBm of the transmitter's frames, 0 when unknown.
+    int8_t noise;                         //Noise floor in dBm, 0 when unknown.
+} __attribute__((packed)) espnow_feedback_t;
+
+/*
+ * Sent by a transmitter ahead of a channel migration, several times since
+ * any one may be lost. Audio packets from switch_seq on go out on channel.
+ */
+typedef struct {
+    uint8_t channel;
+    uint8_t reserved[3];
+    uint32_t switch_seq;
+} __attribute__((packed)) espnow_channel_switch_t;
+
+// Bytes per sample of an ESPNOW_FORMAT_*
+#define ESPNOW_FORMAT_BYTES(format) ((format) == ESPNOW_FORMAT_S24_32 ? 4 : 2)
+
+// Validates everything but the CRC. Parity payloads are not checked against
+// frame_len, they are as long as the longest packet of their group. Feedback
+// and channel packets only have their version, type and length checked.
+
+espnow_header_check_t espnow_header_check(const uint8_t* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __ESPNOW_PROTO_H__
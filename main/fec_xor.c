@@ -0,0 +1,117 @@
+#include "fec_xor.h"
+#include <assert.h>
+#include <string.h>
+
+_Static_assert((FEC_GROUPS & (FEC_GROUPS - 1)) == 0, "FEC_GROUPS must be a power of two");
+_Static_assert(FEC_MAX_K <= 32, "received bitmap is 32 bits");
+
+static void fec_xor(uint8_t *dst, const uint8_t *src, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        dst[i] ^= src[i];
+}
+
+void fec_encoder_init(fec_encoder_t *enc)
+{
+    memset(enc, 0, sizeof(fec_encoder_t));
+}
+
+bool fec_encoder_add(fec_encoder_t *enc, uint32_t k, const uint8_t *payload, uint16_t len)
+{
+    assert(k > 0 && k <= FEC_MAX_K);
+    assert(len <= FEC_MAX_PAYLOAD);
+
+    if (enc->count == 0) {
+        memset(enc->parity, 0, sizeof(enc->parity));
+        enc->len = FEC_PARITY_HEADER;
+        enc->len_xor = 0;
+    }
+    fec_xor(enc->parity + FEC_PARITY_HEADER, payload, len);
+    enc->len_xor ^= len;
+    if (FEC_PARITY_HEADER + len > enc->len)
+        enc->len = FEC_PARITY_HEADER + len;
+
+    if (++enc->count < k)
+        return false;
+    enc->parity[0] = enc->len_xor & 0xff;
+    enc->parity[1] = enc->len_xor >> 8;
+    enc->count = 0;
+    return true;
+}
+
+void fec_decoder_init(fec_decoder_t *dec)
+{
+    memset(dec, 0, sizeof(fec_decoder_t));
+}
+
+static void fec_group_reset(fec_decoder_t *dec, fec_group_t *g, uint32_t base, uint32_t k)
+{
+    if (g->k != 0 && !g->done) {
+        uint32_t missing = g->k - __builtin_popcount(g->received);
+        if (missing > 1 || (missing == 1 && !g->parity))
+            dec->stats.unrecoverable++;
+    }
+    g->base = base;
+    g->k = k;
+    g->received = 0;
+    g->parity = false;
+    g->done = false;
+    g->len = 0;
+    memset(g->acc, 0, sizeof(g->acc));
+}
+
+bool fec_decoder_add(fec_decoder_t *dec, uint32_t seq, uint32_t k, bool parity,
+                     const uint8_t *payload, uint16_t len,
+                     uint32_t *lost_seq, const uint8_t **out, uint16_t *out_len)
+{
+    if (k == 0 || k > FEC_MAX_K || len > FEC_MAX_PAYLOAD + (parity ? FEC_PARITY_HEADER : 0))
+        return false;
+    if (parity && len < FEC_PARITY_HEADER)
+        return false;
+
+    uint32_t base = parity ? seq : seq - seq % k;
+    fec_group_t *g = &dec->groups[(base / k) & (FEC_GROUPS - 1)];
+
+    if (g->k == 0 || g->base != base || g->k != k) {
+        // Packets for a group that was already evicted are of no use
+        if (g->k != 0 && (int32_t)(base - g->base) < 0)
+            return false;
+        fec_group_reset(dec, g, base, k);
+    }
+    if (g->done)
+        return false;
+
+    if (parity) {
+        if (g->parity)
+            return false;
+        g->parity = true;
+        g->len ^= payload[0] | payload[1] << 8;
+        fec_xor(g->acc, payload + FEC_PARITY_HEADER, len - FEC_PARITY_HEADER);
+    } else {
+        uint32_t bit = 1u << (seq - base);
+        if (g->received & bit)
+            return false;
+        g->received |= bit;
+        g->len ^= len;
+        fec_xor(g->acc, payload, len);
+    }
+
+    uint32_t have = __builtin_popcount(g->received);
+    if (have == k) {
+        g->done = true;
+        return false;
+    }
+    if (!g->parity || have != k - 1)
+        return false;
+
+    g->done = true;
+    if (g->len > FEC_MAX_PAYLOAD)
+        return false;
+
+    uint32_t missing = ~g->received & ((k < 32 ? (1u << k) : 0u) - 1);
+    *lost_seq = base + __builtin_ctz(missing);
+    *out = g->acc;
+    *out_len = g->len;
+    dec->stats.recovered++;
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef __FEC_XOR_H__
+#define __FEC_XOR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FEC_MAX_K           16              // Data packets per parity packet
+#define FEC_MAX_PAYLOAD     240
+#define FEC_PARITY_HEADER   2               // XOR of the payload lengths, little endian
+#define FEC_GROUPS          4               // Groups tracked at once, power of two
+
+/*
+ * Single-parity erasure code. Every k data packets the transmitter sends one
+ * parity packet holding the XOR of their lengths followed by the XOR of
+ * their payloads, shorter payloads zero padded. A group is identified by the sequence
+ * number of its first data packet, seq - seq % k. Once the receiver has the
+ * parity and all but one data packet of a group, XORing everything it has
+ * gives back the missing payload.
+ */
+typedef struct {
+    uint8_t parity[FEC_PARITY_HEADER + FEC_MAX_PAYLOAD];
+    uint16_t len;                           // Parity payload length
+    uint16_t len_xor;
+    uint32_t count;
+} fec_encoder_t;
+
+typedef struct {
+    uint32_t base;                          // Sequence number of the first data packet
+    uint32_t k;                             // 0 while unused
+    uint32_t received;                      // Bitmap of data packets seen
+    bool parity;
+    bool done;                              // Recovered or complete, ignore further packets
+    uint16_t len;
+    uint8_t acc[FEC_MAX_PAYLOAD];
+} fec_group_t;
+
+typedef struct {
+    uint32_t recovered;
+    uint32_t unrecoverable;                 // Groups evicted with more than one packet missing
+} fec_stats_t;
+
+typedef struct {
+    fec_group_t groups[FEC_GROUPS];
+    fec_stats_t stats;
+} fec_decoder_t;
+
+void fec_encoder_init(fec_encoder_t* enc);
+
+// Returns true once k payloads have been added, the parity is then in
+// enc->parity/enc->len until the next call
+bool fec_encoder_add(fec_encoder_t* enc, uint32_t k, const uint8_t* payload, uint16_t len);
+
+void fec_decoder_init(fec_decoder_t* dec);
+
+// Feeds a data packet (parity false) or a parity packet (parity true, seq is
+// the group's first sequence number). Returns true when this completes a
+// group with one data packet missing; its sequence number and length are
+// then written to lost_seq and out_len, and out points at its payload until
+// the next call.
+bool fec_decoder_add(fec_decoder_t* dec, uint32_t seq, uint32_t k, bool parity,
+                     const uint8_t* payload, uint16_t len,
+                     uint32_t* lost_seq, const uint8_t** out, uint16_t* out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FEC_XOR_H__
@@ -0,0 +1,103 @@
+#include "gain.h"
+#include <string.h>
+
+#define GAIN_Q30_SHIFT          15              // Q30 state to Q15 gain
+
+// 32-bit samples times a Q15 gain need 64 bits before the shift
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int64_t gain_acc_t;
+#define GAIN_SAMPLE_MAX         INT32_MAX
+#define GAIN_SAMPLE_MIN         INT32_MIN
+#else
+typedef int32_t gain_acc_t;
+#define GAIN_SAMPLE_MAX         INT16_MAX
+#define GAIN_SAMPLE_MIN         INT16_MIN
+#endif
+
+// round(32768 * 10^(-dB / 20)) for 0..-51 dB
+static const uint16_t gain_db_table[1 - GAIN_DB_MIN] = {
+    32768, 29205, 26029, 23198, 20675, 18427, 16423, 14637,
+    13045, 11627, 10362,  9235,  8231,  7336,  6538,  5827,
+     5193,  4629,  4125,  3677,  3277,  2920,  2603,  2320,
+     2068,  1843,  1642,  1464,  1305,  1163,  1036,   924,
+      823,   734,   654,   583,   519,   463,   413,   368,
+      328,   292,   260,   232,   207,   184,   164,   146,
+      130,   116,   104,    92,
+};
+
+void gain_init(gain_t *gain)
+{
+    memset(gain, 0, sizeof(gain_t));
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+        gain->current[ch] = GAIN_UNITY << GAIN_Q30_SHIFT;
+        gain->target[ch] = GAIN_UNITY << GAIN_Q30_SHIFT;
+    }
+}
+
+int32_t gain_from_db(int16_t db256)
+{
+    if (db256 == GAIN_DB_SILENCE)
+        return 0;
+    if (db256 >= 0)
+        return GAIN_UNITY;
+    int32_t atten = -(int32_t)db256;
+    if (atten >= -GAIN_DB_MIN * 256)
+        return gain_db_table[-GAIN_DB_MIN];
+
+    // Linear between whole dB. Within 0.08 dB of exact, the Q15 steps
+    // near -50 dB being the coarser part
+    uint32_t db = atten >> 8, frac = atten & 0xff;
+    int32_t a = gain_db_table[db], b = gain_db_table[db + 1];
+    return a - (((a - b) * (int32_t)frac + 128) >> 8);
+}
+
+void gain_set(gain_t *gain, int channel, int32_t q15)
+{
+    gain->target[channel] = q15 << GAIN_Q30_SHIFT;
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        gain->step[ch] = (gain->target[ch] - gain->current[ch]) / GAIN_RAMP_FRAMES;
+    gain->ramp_left = GAIN_RAMP_FRAMES;
+}
+
+AUDIO_HOT static audio_sample_t gain_saturate(gain_acc_t acc)
+{
+    acc = (acc + (1 << 14)) >> 15;
+    if (acc > GAIN_SAMPLE_MAX)
+        return GAIN_SAMPLE_MAX;
+    if (acc < GAIN_SAMPLE_MIN)
+        return GAIN_SAMPLE_MIN;
+    return acc;
+}
+
+AUDIO_HOT void gain_apply(gain_t *gain, audio_sample_t *samples, size_t frames)
+{
+    size_t i = 0;
+
+    // Ramp frame by frame until on target, landing exactly on it
+    for (; i < frames && gain->ramp_left > 0; i++) {
+        gain->ramp_left--;
+        for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+            gain->current[ch] = gain->ramp_left ? gain->current[ch] + gain->step[ch] : gain->target[ch];
+            int32_t g = gain->current[ch] >> GAIN_Q30_SHIFT;
+            audio_sample_t *s = &samples[i * AUDIO_CHANNELS + ch];
+            *s = gain_saturate((gain_acc_t)*s * g);
+        }
+    }
+    if (i == frames)
+        return;
+
+    bool unity = true;
+    int32_t g[AUDIO_CHANNELS];
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+        g[ch] = gain->current[ch] >> GAIN_Q30_SHIFT;
+        unity = unity && g[ch] == GAIN_UNITY;
+    }
+    if (unity)
+        return;
+
+    audio_sample_t *s = &samples[i * AUDIO_CHANNELS];
+    for (; i < frames; i++) {
+        for (int ch = 0; ch < AUDIO_CHANNELS; ch++, s++)
+            *s = gain_saturate((gain_acc_t)*s * g[ch]);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef __GAIN_H__
+#define __GAIN_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "audio_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GAIN_UNITY              32768           // Q15 gain of 1.0
+#define GAIN_DB_MIN             (-51)           // Lowest level in the table, quieter clamps to it
+#define GAIN_RAMP_FRAMES        256             // A change glides over 5.3 ms at 48 kHz
+#define GAIN_DB_SILENCE         ((int16_t)0x8000)   // UAC2 volume meaning minus infinity
+
+/*
+ * Per channel gain with a per frame ramp, so volume changes do not zipper.
+ * Levels come from UAC2 volume values, dB in 1/256 steps, through a table
+ * of Q15 gains per dB interpolated on the fraction. Gains are Q15 like the
+ * mixer's and the result saturates to the sample range. Unity on every
+ * channel with no ramp running passes the samples through untouched.
+ * Setter and gain_apply must run in the same task.
+ */
+typedef struct {
+    int32_t current[AUDIO_CHANNELS];            // Q30, the fraction lets slow ramps move
+    int32_t target[AUDIO_CHANNELS];             // Q30
+    int32_t step[AUDIO_CHANNELS];               // Q30 per frame
+    uint32_t ramp_left;                         // Frames until every channel is on target
+} gain_t;
+
+void gain_init(gain_t* gain);
+
+// Q15 gain of a UAC2 volume, attenuation only
+int32_t gain_from_db(int16_t db256);
+
+// Ramps a channel to a Q15 gain, restarting the ramp of every channel
+void gain_set(gain_t* gain, int channel, int32_t q15);
+
+// Applies the gains in place to frames of interleaved samples
+void gain_apply(gain_t* gain, audio_sample_t* samples, size_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __GAIN_H__
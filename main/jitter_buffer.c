@@ -0,0 +1,96 @@
+#include "jitter_buffer.h"
+#include <assert.h>
+#include <string.h>
+
+#define JITTER_BUFFER_SLOT(seq)     ((seq) & (JITTER_BUFFER_MAX_DEPTH - 1))
+
+_Static_assert((JITTER_BUFFER_MAX_DEPTH & (JITTER_BUFFER_MAX_DEPTH - 1)) == 0,
+               "jitter buffer size must be a power of two");
+
+void jitter_buffer_init(jitter_buffer_t *jb, uint32_t depth, jitter_buffer_release_t release, void *release_ctx)
+{
+    assert(depth > 0 && depth < JITTER_BUFFER_MAX_DEPTH);
+
+    memset(jb, 0, sizeof(jitter_buffer_t));
+    jb->depth = depth;
+    jb->release = release;
+    jb->release_ctx = release_ctx;
+}
+
+void jitter_buffer_reset(jitter_buffer_t *jb)
+{
+    for (int i = 0; i < JITTER_BUFFER_MAX_DEPTH; i++) {
+        if (jb->frames[i] != NULL) {
+            if (jb->release)
+                jb->release(jb->frames[i], jb->release_ctx);
+            jb->frames[i] = NULL;
+        }
+    }
+    jb->started = false;
+}
+
+jitter_buffer_insert_t jitter_buffer_insert(jitter_buffer_t *jb, uint32_t seq, void *frame)
+{
+    assert(frame != NULL);
+
+    if (!jb->started) {
+        jb->started = true;
+        jb->next_seq = jb->newest_seq = seq;
+    }
+
+    int32_t ahead = (int32_t)(seq - jb->next_seq);
+    if (ahead < -(int32_t)JITTER_BUFFER_MAX_DEPTH || ahead >= JITTER_BUFFER_MAX_DEPTH) {
+        // Transmitter restarted or a loss burst longer than the buffer
+        jb->stats.resync++;
+        jitter_buffer_reset(jb);
+        jb->started = true;
+        jb->next_seq = jb->newest_seq = seq;
+        ahead = 0;
+    }
+
+    if (ahead < 0) {
+        jb->stats.late++;
+        return JITTER_BUFFER_LATE;
+    }
+
+    uint32_t slot = JITTER_BUFFER_SLOT(seq);
+    if (jb->frames[slot] != NULL) {
+        jb->stats.duplicate++;
+        return JITTER_BUFFER_DUPLICATE;
+    }
+
+    jb->frames[slot] = frame;
+    jb->seqs[slot] = seq;
+    jb->stats.inserted++;
+
+    if ((int32_t)(seq - jb->newest_seq) > 0)
+        jb->newest_seq = seq;
+    else if (seq != jb->newest_seq)
+        jb->stats.reordered++;
+
+    return JITTER_BUFFER_INSERTED;
+}
+
+jitter_buffer_pop_t jitter_buffer_pop(jitter_buffer_t *jb, void **frame, uint32_t *seq)
+{
+    if (!jb->started)
+        return JITTER_BUFFER_WAIT;
+
+    uint32_t slot = JITTER_BUFFER_SLOT(jb->next_seq);
+    if (jb->frames[slot] != NULL) {
+        assert(jb->seqs[slot] == jb->next_seq);
+        *frame = jb->frames[slot];
+        *seq = jb->next_seq++;
+        jb->frames[slot] = NULL;
+        return JITTER_BUFFER_FRAME;
+    }
+
+    if ((int32_t)(jb->newest_seq - jb->next_seq) >= (int32_t)jb->depth) {
+        *frame = NULL;
+        *seq = jb->next_seq++;
+        jb->stats.lost++;
+        return JITTER_BUFFER_LOST;
+    }
+
+    return JITTER_BUFFER_WAIT;
+}
@@ -0,0 +1,71 @@
+#ifndef __JITTER_BUFFER_H__
+#define __JITTER_BUFFER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JITTER_BUFFER_MAX_DEPTH     16      // Power of two
+
+typedef enum {
+    JITTER_BUFFER_INSERTED,                 // Buffer owns the frame
+    JITTER_BUFFER_DUPLICATE,                // Caller keeps the frame
+    JITTER_BUFFER_LATE,                     // Caller keeps the frame
+} jitter_buffer_insert_t;
+
+typedef enum {
+    JITTER_BUFFER_WAIT,                     // Next frame not due yet
+    JITTER_BUFFER_FRAME,                    // Next frame, ownership passes to the caller
+    JITTER_BUFFER_LOST,                     // Next frame missed its playout deadline
+} jitter_buffer_pop_t;
+
+typedef struct {
+    uint32_t inserted;
+    uint32_t reordered;                     // Arrived after a later frame, still in time
+    uint32_t duplicate;
+    uint32_t late;                          // Arrived after its playout deadline
+    uint32_t lost;
+    uint32_t resync;
+} jitter_buffer_stats_t;
+
+typedef void (*jitter_buffer_release_t)(void* frame, void* ctx);
+
+/*
+ * Reorders frames by sequence number. Frames are opaque pointers: the
+ * buffer never copies them. In-order frames are released immediately; a gap
+ * holds back everything behind it until either the missing frame arrives
+ * or a frame depth sequence numbers newer does, at which point the missing
+ * one's playout deadline has passed and it is reported lost.
+ */
+typedef struct {
+    void* frames[JITTER_BUFFER_MAX_DEPTH];
+    uint32_t seqs[JITTER_BUFFER_MAX_DEPTH];
+    uint32_t next_seq;                      // Next sequence number to play out
+    uint32_t newest_seq;
+    uint32_t depth;
+    bool started;
+    jitter_buffer_release_t release;        // Frees frames dropped on resync
+    void* release_ctx;
+    jitter_buffer_stats_t stats;
+} jitter_buffer_t;
+
+// depth is the number of frames a gap may hold back playout, it must be
+// less than JITTER_BUFFER_MAX_DEPTH
+void jitter_buffer_init(jitter_buffer_t* jb, uint32_t depth, jitter_buffer_release_t release, void* release_ctx);
+
+// Releases every held frame and waits for a new first frame
+void jitter_buffer_reset(jitter_buffer_t* jb);
+
+jitter_buffer_insert_t jitter_buffer_insert(jitter_buffer_t* jb, uint32_t seq, void* frame);
+
+// Call until it returns JITTER_BUFFER_WAIT after every insert
+jitter_buffer_pop_t jitter_buffer_pop(jitter_buffer_t* jb, void** frame, uint32_t* seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __JITTER_BUFFER_H__
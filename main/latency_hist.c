@@ -0,0 +1,42 @@
+#include "latency_hist.h"
+#include <string.h>
+
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+void latency_hist_add(latency_hist_t *hist, uint32_t us)
+{
+    uint32_t bucket = us / LATENCY_HIST_BUCKET_US;
+    if (bucket >= LATENCY_HIST_BUCKETS)
+        bucket = LATENCY_HIST_BUCKETS - 1;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    if (us > hist->max_us)
+        hist->max_us = us;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t permille)
+{
+    if (hist->count == 0)
+        return 0;
+
+    // Rank of the sample, rounded up so p100 is the last one
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * permille + 999) / 1000);
+    if (rank == 0)
+        rank = 1;
+
+    uint32_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS - 1; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t edge = (i + 1) * LATENCY_HIST_BUCKET_US;
+            return edge < hist->max_us ? edge : hist->max_us;
+        }
+    }
+
+    // Overflow bucket, the max is the only bound known
+    return hist->max_us;
+}
@@ -0,0 +1,35 @@
+#ifndef __LATENCY_HIST_H__
+#define __LATENCY_HIST_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_HIST_BUCKETS    64
+#define LATENCY_HIST_BUCKET_US  100         // Last bucket also holds everything longer
+
+/*
+ * Fixed-width histogram of latencies in us. Percentiles are read back at
+ * bucket resolution, rounded up to the bucket's upper edge, so adding a
+ * sample is a division and an increment with no sorting or heap.
+ */
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_t;
+
+void latency_hist_reset(latency_hist_t* hist);
+
+void latency_hist_add(latency_hist_t* hist, uint32_t us);
+
+// Latency not exceeded by permille / 1000 of the samples, 0 when empty
+uint32_t latency_hist_percentile(const latency_hist_t* hist, uint32_t permille);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LATENCY_HIST_H__
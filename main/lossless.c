@@ -0,0 +1,208 @@
+#include "lossless.h"
+#include "audio_format.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define LOSSLESS_MAX_RICE   20
+
+typedef struct {
+    uint8_t* p;
+    uint8_t* end;
+    uint32_t acc;
+    int bits;                               // Pending bits in acc, below 8 between calls
+} bit_writer_t;
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint32_t acc;
+    int bits;
+} bit_reader_t;
+
+static inline int32_t lossless_predict(const int16_t* x, size_t i, int order)
+{
+    switch (order) {
+    case 0:
+        return 0;
+    case 1:
+        return x[i - 1];
+    case 2:
+        return 2 * x[i - 1] - x[i - 2];
+    default:
+        return 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+    }
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u)
+{
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+// Returns false once the output would run past end
+static inline bool bw_put(bit_writer_t* bw, uint32_t value, int n)
+{
+    while (n > 0) {
+        int take = n > 16 ? 16 : n;
+        n -= take;
+        bw->acc = bw->acc << take | ((value >> n) & ((1u << take) - 1));
+        bw->bits += take;
+        while (bw->bits >= 8) {
+            if (bw->p == bw->end)
+                return false;
+            bw->bits -= 8;
+            *bw->p++ = bw->acc >> bw->bits;
+        }
+    }
+    return true;
+}
+
+static inline bool bw_flush(bit_writer_t* bw)
+{
+    return bw->bits == 0 || bw_put(bw, 0, 8 - bw->bits);
+}
+
+static inline int br_bit(bit_reader_t* br)
+{
+    if (br->bits == 0) {
+        if (br->p == br->end)
+            return -1;
+        br->acc = *br->p++;
+        br->bits = 8;
+    }
+    return (br->acc >> --br->bits) & 1;
+}
+
+static inline bool br_get(bit_reader_t* br, int n, uint32_t* value)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < n; i++) {
+        int bit = br_bit(br);
+        if (bit < 0)
+            return false;
+        v = v << 1 | bit;
+    }
+    *value = v;
+    return true;
+}
+
+static size_t lossless_raw(const int16_t* in, size_t n, uint8_t* out)
+{
+    out[0] = LOSSLESS_RAW;
+    out[1] = 0;
+    out[2] = n & 0xff;
+    out[3] = n >> 8;
+    memcpy(out + LOSSLESS_HEADER_LEN, in, n * sizeof(int16_t));
+    return LOSSLESS_MAX_LEN(n);
+}
+
+size_t lossless_encode(const int16_t* in, size_t n, uint8_t* out)
+{
+    // Pick the order with the smallest residual magnitude
+    int order = 0;
+    uint64_t best = UINT64_MAX;
+    for (int o = 0; o <= LOSSLESS_MAX_ORDER && (size_t)o < n; o++) {
+        uint64_t sum = 0;
+        for (size_t i = o; i < n; i++)
+            sum += zigzag(in[i] - lossless_predict(in, i, o));
+        if (sum < best) {
+            best = sum;
+            order = o;
+        }
+    }
+    if (n <= (size_t)order)
+        return lossless_raw(in, n, out);
+
+    // Rice parameter near log2 of the mean, refined on the exact cost
+    size_t count = n - order;
+    uint32_t mean = best / count;
+    int k = 0;
+    while (k < LOSSLESS_MAX_RICE && (mean >> (k + 1)) > 0)
+        k++;
+    uint64_t best_bits = UINT64_MAX;
+    int best_k = k;
+    for (int c = k > 0 ? k - 1 : 0; c <= k + 1 && c <= LOSSLESS_MAX_RICE; c++) {
+        uint64_t bits = (uint64_t)count * (c + 1);
+        for (size_t i = order; i < n; i++)
+            bits += zigzag(in[i] - lossless_predict(in, i, order)) >> c;
+        if (bits < best_bits) {
+            best_bits = bits;
+            best_k = c;
+        }
+    }
+    size_t raw_len = LOSSLESS_MAX_LEN(n);
+    if (LOSSLESS_HEADER_LEN + order * 2 + (best_bits + 7) / 8 >= raw_len)
+        return lossless_raw(in, n, out);
+    k = best_k;
+
+    out[0] = order;
+    out[1] = k;
+    out[2] = n & 0xff;
+    out[3] = n >> 8;
+    uint8_t* p = out + LOSSLESS_HEADER_LEN;
+    for (int i = 0; i < order; i++) {
+        *p++ = (uint16_t)in[i] & 0xff;
+        *p++ = (uint16_t)in[i] >> 8;
+    }
+
+    bit_writer_t bw = { .p = p, .end = out + raw_len };
+    for (size_t i = order; i < n; i++) {
+        uint32_t u = zigzag(in[i] - lossless_predict(in, i, order));
+        uint32_t q = u >> k;
+        while (q >= 16) {
+            if (!bw_put(&bw, 0xffff, 16))
+                return lossless_raw(in, n, out);
+            q -= 16;
+        }
+        if (!bw_put(&bw, ((1u << q) - 1) << 1, q + 1) || !bw_put(&bw, u, k))
+            return lossless_raw(in, n, out);
+    }
+    if (!bw_flush(&bw))
+        return lossless_raw(in, n, out);
+    return bw.p - out;
+}
+
+AUDIO_HOT size_t lossless_decode(const uint8_t* in, size_t len, int16_t* out, size_t max)
+{
+    if (len < LOSSLESS_HEADER_LEN)
+        return 0;
+    int order = in[0];
+    int k = in[1];
+    size_t n = in[2] | in[3] << 8;
+    if (n > max)
+        return 0;
+
+    if (order == LOSSLESS_RAW) {
+        if (len != LOSSLESS_MAX_LEN(n))
+            return 0;
+        memcpy(out, in + LOSSLESS_HEADER_LEN, n * sizeof(int16_t));
+        return n;
+    }
+    if (order > LOSSLESS_MAX_ORDER || k > LOSSLESS_MAX_RICE || n <= (size_t)order ||
+        len < LOSSLESS_HEADER_LEN + order * 2u)
+        return 0;
+
+    const uint8_t* p = in + LOSSLESS_HEADER_LEN;
+    for (int i = 0; i < order; i++, p += 2)
+        out[i] = (int16_t)(p[0] | p[1] << 8);
+
+    bit_reader_t br = { .p = p, .end = in + len };
+    for (size_t i = order; i < n; i++) {
+        uint32_t q = 0;
+        int bit;
+        while ((bit = br_bit(&br)) == 1) {
+            // Order 3 residuals of 16-bit samples fit in 20 bits zigzagged
+            if (++q > (1u << 20) >> k)
+                return 0;
+        }
+        uint32_t r;
+        if (bit < 0 || !br_get(&br, k, &r))
+            return 0;
+        out[i] = (int16_t)(lossless_predict(out, i, order) + unzigzag(q << k | r));
+    }
+    return n;
+}
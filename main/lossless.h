@@ -0,0 +1,36 @@
+#ifndef __LOSSLESS_H__
+#define __LOSSLESS_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOSSLESS_HEADER_LEN         4           // Method, Rice parameter, sample count (uint16 LE)
+#define LOSSLESS_MAX_ORDER          3
+#define LOSSLESS_RAW                0xff        // Method byte of an uncompressed block
+#define LOSSLESS_MAX_LEN(samples)   (LOSSLESS_HEADER_LEN + (samples) * 2)
+
+/*
+ * Lossless 16-bit PCM blocks. Each block picks the fixed polynomial
+ * predictor (order 0-3, as in FLAC) with the smallest residual, stores
+ * the first order samples verbatim and Rice codes the zigzagged residuals
+ * of the rest with a single parameter. When that would not be smaller than
+ * the PCM the block is stored raw, so a block never exceeds
+ * LOSSLESS_MAX_LEN.
+ */
+
+// Encodes n samples, n at most UINT16_MAX. Returns the bytes written.
+size_t lossless_encode(const int16_t* in, size_t n, uint8_t* out);
+
+// Decodes a block into at most max samples. Returns the samples written,
+// 0 if the block is malformed or longer than max.
+size_t lossless_decode(const uint8_t* in, size_t len, int16_t* out, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __LOSSLESS_H__
@@ -25,6 +25,7 @@
 #include "es8388_i2c.h"
 #include "sdkconfig.h"
 #include "math.h"
+#include "war_config.h"
 #include "war_wifi.h"
 #include "war_espnow.h"
 #include "war_i2s_audio.h"
@@ -32,6 +33,20 @@
 
 static const char *TAG = "WAR Main";
 
+// Written once by the ESP-NOW task, read by every enabled sink
+static ringbuf_bcast_t audio_rbuf;
+
+// Called from the ESP-NOW task whenever the received stream changes format
+static void stream_format_changed(const espnow_stream_format_t *format)
+{
+#ifdef CONFIG_USB_AUDIO_ENABLED
+    usb_audio_set_format(format);
+#endif
+#if !defined(CONFIG_USB_AUDIO_ENABLED) || I2S_SINK_WITH_USB
+    war_i2s_audio_set_format(format);
+#endif
+}
+
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF PROTYPES
 //--------------------------------------------------------------------+
@@ -46,6 +61,10 @@ void app_main(void)
     }
     ESP_ERROR_CHECK( ret );
 
+    ringbuf_bcast_reset(&audio_rbuf);
+    espnow_set_rbuf(&audio_rbuf);
+    espnow_set_format_cb(stream_format_changed);
+
 #ifdef CONFIG_USB_AUDIO_ENABLED
     //Sine Wave 440HZ
     double delta = 1.0 / (double)current_sample_rate;
@@ -60,14 +79,14 @@ void app_main(void)
     tinyusb_config_t tusb_cfg = {}; // the configuration using default values
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
     ESP_LOGI(TAG, "USB initialization DONE");
-    init_usb_audio_ringbuffer();
+    init_usb_audio_ringbuffer(&audio_rbuf);
 #endif
 
     war_wifi_init();
     ESP_ERROR_CHECK( espnow_init(true) );
 
-#ifndef CONFIG_USB_AUDIO_ENABLED
+#if !defined(CONFIG_USB_AUDIO_ENABLED) || I2S_SINK_WITH_USB
     es_i2c_init();
-    war_i2s_audio_init();
+    war_i2s_audio_init(&audio_rbuf);
 #endif
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "mixer.h"
+#include <string.h>
+
+#define RINGBUF_NAME            ringbuf_mix
+#define RINGBUF_TYPE            audio_sample_t
+#define RINGBUF_CAPACITY        MIXER_FIFO_CAPACITY
+#include "ringbuf_impl.h"
+
+#define MIXER_SAMPLES           (MIXER_FRAME * AUDIO_CHANNELS)
+
+// 32-bit samples times a Q15 gain need 64 bits before the shift
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int64_t mixer_acc_t;
+#define MIXER_SAMPLE_MAX        INT32_MAX
+#define MIXER_SAMPLE_MIN        INT32_MIN
+#else
+typedef int32_t mixer_acc_t;
+#define MIXER_SAMPLE_MAX        INT16_MAX
+#define MIXER_SAMPLE_MIN        INT16_MIN
+#endif
+
+void mixer_init(mixer_t *mixer)
+{
+    memset(mixer, 0, sizeof(mixer_t));
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        ringbuf_mix_reset(&mixer->inputs[i].fifo);
+        mixer->inputs[i].gain = MIXER_UNITY;
+    }
+}
+
+void mixer_set_active(mixer_t *mixer, int input, bool active)
+{
+    mixer_input_t *in = &mixer->inputs[input];
+
+    ringbuf_mix_reset(&in->fifo);
+    in->active = active;
+    in->lagged = 0;
+}
+
+void mixer_set_gain(mixer_t *mixer, int input, int32_t gain)
+{
+    mixer->inputs[input].gain = gain;
+}
+
+AUDIO_HOT size_t mixer_write(mixer_t *mixer, int input, const audio_sample_t *samples, size_t n)
+{
+    mixer_input_t *in = &mixer->inputs[input];
+
+    // Whole frames only, so a full FIFO never splits one
+    size_t avail = ringbuf_mix_avail(&in->fifo);
+    if (n > avail)
+        n = avail - avail % AUDIO_CHANNELS;
+
+    return ringbuf_mix_write_buf(&in->fifo, samples, n);
+}
+
+// Adds up to n samples of a source into acc, returns the number it had
+AUDIO_HOT static size_t mixer_accumulate(mixer_input_t *in, mixer_acc_t *acc, size_t n)
+{
+    size_t done = 0;
+
+    // Twice at most, at the FIFO's wrap point
+    while (done < n) {
+        size_t len;
+        const audio_sample_t *src = ringbuf_mix_peek(&in->fifo, n - done, &len);
+        if (len == 0)
+            break;
+        for (size_t i = 0; i < len; i++)
+            acc[done + i] += ((mixer_acc_t)src[i] * in->gain) >> 15;
+        ringbuf_mix_consume(&in->fifo, len);
+        done += len;
+    }
+
+    return done;
+}
+
+AUDIO_HOT size_t mixer_mix(mixer_t *mixer, audio_sample_t *out)
+{
+    size_t least = SIZE_MAX, most = 0;
+    int active = 0, last = 0;
+
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        mixer_input_t *in = &mixer->inputs[i];
+        if (!in->active)
+            continue;
+        size_t size = ringbuf_mix_size(&in->fifo);
+        least = size < least ? size : least;
+        most = size > most ? size : most;
+        active++;
+        last = i;
+    }
+
+    // Due when everyone has a block, or someone is too far ahead to wait
+    if (active == 0 || most < MIXER_SAMPLES)
+        return 0;
+    if (least < MIXER_SAMPLES && most < MIXER_LAG_FRAMES * AUDIO_CHANNELS)
+        return 0;
+
+    if (active == 1 && mixer->inputs[last].gain == MIXER_UNITY)
+        return ringbuf_mix_read_buf(&mixer->inputs[last].fifo, out, MIXER_SAMPLES);
+
+    mixer_acc_t acc[MIXER_SAMPLES] = {0};
+    for (int i = 0; i < MIXER_MAX_SOURCES; i++) {
+        mixer_input_t *in = &mixer->inputs[i];
+        if (in->active && mixer_accumulate(in, acc, MIXER_SAMPLES) < MIXER_SAMPLES)
+            in->lagged += MIXER_FRAME;
+    }
+
+    for (size_t i = 0; i < MIXER_SAMPLES; i++) {
+        mixer_acc_t s = acc[i];
+        out[i] = s > MIXER_SAMPLE_MAX ? MIXER_SAMPLE_MAX : s < MIXER_SAMPLE_MIN ? MIXER_SAMPLE_MIN : s;
+    }
+
+    return MIXER_SAMPLES;
+}
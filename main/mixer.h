@@ -0,0 +1,64 @@
+#ifndef __MIXER_H__
+#define __MIXER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_format.h"
+
+#define MIXER_MAX_SOURCES       4
+#define MIXER_FRAME             48              // Frames mixed at a time, 1 ms
+#define MIXER_FIFO_FRAMES       512             // Per source, power of two
+#define MIXER_LAG_FRAMES        (MIXER_FRAME * 8)   // A source this far behind the others is mixed as silence
+#define MIXER_UNITY             32768           // Q15 gain of 1.0
+
+// Per source queue of sink samples waiting to be mixed
+#define MIXER_FIFO_CAPACITY     (MIXER_FIFO_FRAMES * AUDIO_CHANNELS)
+
+#define RINGBUF_NAME            ringbuf_mix
+#define RINGBUF_TYPE            audio_sample_t
+#define RINGBUF_CAPACITY        MIXER_FIFO_CAPACITY
+#include "ringbuf_decl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    ringbuf_mix_t fifo;
+    int32_t gain;                               // Q15, MIXER_UNITY passes the source through
+    bool active;
+    uint32_t lagged;                            // Frames mixed as silence while the source fell behind
+} mixer_input_t;
+
+/*
+ * Sums the decoded audio of up to MIXER_MAX_SOURCES transmitters. Each
+ * source queues sink samples in its own FIFO as its packets play out; a
+ * frame is mixed once every active source has it, or once the fullest
+ * source is MIXER_LAG_FRAMES ahead, in which case sources that are behind
+ * contribute silence for what they lack. Gains are Q15 and the sum
+ * saturates to the sample range. A lone source at unity gain is copied
+ * through untouched. Writer and mixer must run in the same task.
+ */
+typedef struct {
+    mixer_input_t inputs[MIXER_MAX_SOURCES];
+} mixer_t;
+
+void mixer_init(mixer_t* mixer);
+
+// Activating or deactivating a source empties its FIFO
+void mixer_set_active(mixer_t* mixer, int input, bool active);
+
+void mixer_set_gain(mixer_t* mixer, int input, int32_t gain);
+
+// Queues whole frames of sink samples, returns the number of samples queued
+size_t mixer_write(mixer_t* mixer, int input, const audio_sample_t* samples, size_t n);
+
+// Mixes one MIXER_FRAME frame block into out if one is due. Returns the
+// number of samples written, 0 or MIXER_FRAME * AUDIO_CHANNELS.
+size_t mixer_mix(mixer_t* mixer, audio_sample_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MIXER_H__
@@ -0,0 +1,19 @@
+#include "packet_model.h"
+
+void packet_model(uint32_t ms, uint32_t parts, uint32_t header_len, uint32_t payload_len,
+                  uint32_t fec_k, uint32_t copies, uint32_t jitter_depth, packet_model_t *out)
+{
+    uint32_t audio_packets = 1000 * parts / ms;
+
+    // Copies, or one parity packet per fec_k
+    if (fec_k == 0)
+        out->packets_per_sec = audio_packets * (1 + copies);
+    else
+        out->packets_per_sec = audio_packets + (audio_packets + fec_k - 1) / fec_k;
+
+    out->air_bytes = PACKET_MODEL_ESPNOW_OVERHEAD + header_len + payload_len;
+    out->overhead_permille =
+        (PACKET_MODEL_ESPNOW_OVERHEAD + header_len) * 1000 / out->air_bytes;
+    out->latency_us = ms * 1000;
+    out->worst_latency_us = out->latency_us + jitter_depth * ms * 1000 / parts;
+}
@@ -0,0 +1,37 @@
+#ifndef __PACKET_MODEL_H__
+#define __PACKET_MODEL_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bytes every ESP-NOW frame carries around its data: 802.11 MAC header (24),
+// action category, OUI and random bytes (8), vendor element header (7), FCS (4)
+#define PACKET_MODEL_ESPNOW_OVERHEAD    43
+
+/*
+ * Cost of one packet duration setting, integer only so it can be evaluated
+ * on the target or on a host.
+ */
+typedef struct {
+    uint32_t packets_per_sec;               // Including redundancy
+    uint32_t air_bytes;                     // One frame as sent, overhead included
+    uint32_t overhead_permille;             // Header bytes per frame byte
+    uint32_t latency_us;                    // Transmitter waiting for the packet's audio
+    uint32_t worst_latency_us;              // Plus the jitter buffer holding back a gap
+} packet_model_t;
+
+// ms of audio split over parts packets, each carrying payload_len bytes
+// after a header_len byte packet header. fec_k is the audio packets per
+// parity packet, 0 to send copies extra copies of each packet instead.
+// jitter_depth is in packets.
+void packet_model(uint32_t ms, uint32_t parts, uint32_t header_len, uint32_t payload_len,
+                  uint32_t fec_k, uint32_t copies, uint32_t jitter_depth, packet_model_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PACKET_MODEL_H__
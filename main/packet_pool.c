@@ -0,0 +1,64 @@
+#include "packet_pool.h"
+#include <assert.h>
+
+#define PACKET_POOL_NIL         0xFFFF
+#define PACKET_POOL_INDEX(head) ((head) & 0xFFFF)
+#define PACKET_POOL_HEAD(tag, index) ((((tag) + 1) << 16) | (index))
+
+_Static_assert(PACKET_POOL_SIZE < PACKET_POOL_NIL, "packet pool too large");
+
+void packet_pool_init(packet_pool_t *pool)
+{
+    for (int i = 0; i < PACKET_POOL_SIZE; i++) {
+        pool->slots[i].len = 0;
+        pool->slots[i].next = (i + 1 < PACKET_POOL_SIZE) ? i + 1 : PACKET_POOL_NIL;
+    }
+    atomic_init(&pool->head, 0);
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->exhausted, 0);
+}
+
+packet_slot_t *packet_pool_alloc(packet_pool_t *pool)
+{
+    uint32_t head = atomic_load_explicit(&pool->head, memory_order_acquire);
+    uint32_t next;
+    do {
+        uint32_t index = PACKET_POOL_INDEX(head);
+        if (index == PACKET_POOL_NIL) {
+            atomic_fetch_add_explicit(&pool->exhausted, 1, memory_order_relaxed);
+            return NULL;
+        }
+        next = PACKET_POOL_HEAD(head >> 16, pool->slots[index].next);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->head, &head, next,
+                                                    memory_order_acquire, memory_order_acquire));
+
+    atomic_fetch_add_explicit(&pool->in_use, 1, memory_order_relaxed);
+
+    return &pool->slots[PACKET_POOL_INDEX(head)];
+}
+
+void packet_pool_free(packet_pool_t *pool, packet_slot_t *slot)
+{
+    uint32_t index = slot - pool->slots;
+    assert(index < PACKET_POOL_SIZE);
+
+    atomic_fetch_sub_explicit(&pool->in_use, 1, memory_order_relaxed);
+
+    uint32_t head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+    uint32_t next;
+    do {
+        slot->next = PACKET_POOL_INDEX(head);
+        next = PACKET_POOL_HEAD(head >> 16, index);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->head, &head, next,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+uint32_t packet_pool_in_use(packet_pool_t *pool)
+{
+    return atomic_load_explicit(&pool->in_use, memory_order_relaxed);
+}
+
+uint32_t packet_pool_take_exhausted(packet_pool_t *pool)
+{
+    return atomic_exchange_explicit(&pool->exhausted, 0, memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+#ifndef __PACKET_POOL_H__
+#define __PACKET_POOL_H__
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "esp_now.h"
+#include "war_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Slots one source holds at most: a full jitter buffer, plus the packet FEC
+// rebuilds while the parity packet that completed its group is still held
+#define PACKET_POOL_SOURCE_SLOTS    (JITTER_BUFFER_DEPTH + (ESPNOW_FEC_K > 0 ? 1 : 0))
+// Every source holding that many while the receive queue is full
+#define PACKET_POOL_SIZE        (ESPNOW_MAX_SOURCES * PACKET_POOL_SOURCE_SLOTS + ESPNOW_QUEUE_SIZE)
+#define PACKET_POOL_SLOT_LEN    ESP_NOW_MAX_DATA_LEN
+
+typedef struct {
+    uint8_t data[PACKET_POOL_SLOT_LEN] __attribute__((aligned(4)));  // Keeps 32-bit payloads aligned
+    uint16_t len;
+    uint16_t next;                      // Free list link, owned by the pool
+} packet_slot_t;
+
+/*
+ * Fixed pool of maximum-size ESP-NOW frames. The free list is a lock-free
+ * stack whose head carries an ABA tag next to the slot index, so slots can
+ * be taken in the Wi-Fi driver callback and returned from any task without
+ * a lock or the heap.
+ */
+typedef struct {
+    packet_slot_t slots[PACKET_POOL_SIZE];
+    atomic_uint head;                   // tag << 16 | slot index
+    atomic_uint in_use;
+    atomic_uint exhausted;              // Failed allocations, see packet_pool_take_exhausted
+} packet_pool_t;
+
+void packet_pool_init(packet_pool_t* pool);
+
+// Returns NULL when every slot is taken
+packet_slot_t* packet_pool_alloc(packet_pool_t* pool);
+
+void packet_pool_free(packet_pool_t* pool, packet_slot_t* slot);
+
+uint32_t packet_pool_in_use(packet_pool_t* pool);
+
+// Allocations that found the pool empty since the previous call. Safe from
+// any task, a failure racing with the call is counted in the next one.
+uint32_t packet_pool_take_exhausted(packet_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PACKET_POOL_H__
@@ -0,0 +1,200 @@
+#include "plc.h"
+#include <string.h>
+
+#define PLC_DECIMATION      4
+#define PLC_WINDOW          240                 // Correlation window, full rate samples
+#define PLC_REFINE          (PLC_DECIMATION - 1)
+#define PLC_CH              AUDIO_CHANNELS
+#define PLC_HISTORY_MASK    (PLC_HISTORY_LEN - 1)
+#define PLC_DECAY_SCALE     ((1u << 31) / PLC_DECAY_LEN)    // Q16 of the Q15 level per decay frame left
+
+// 32-bit samples times a Q15 weight need 64 bits before the shift
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int64_t plc_acc_t;
+#else
+typedef int32_t plc_acc_t;
+#endif
+
+_Static_assert(PLC_HISTORY_LEN >= PLC_WINDOW + PLC_MAX_PITCH + PLC_REFINE,
+               "history too short for the pitch search");
+_Static_assert(PLC_OLA_LEN <= PLC_MIN_PITCH, "seam crossfade longer than a period");
+_Static_assert((PLC_HISTORY_LEN & PLC_HISTORY_MASK) == 0, "history length not a power of two");
+_Static_assert(PLC_OLA_LEN == 48, "plc_ola_fade is for 48 frames");
+
+// Q15 weight of the incoming side of a crossfade, (i + 1) / (PLC_OLA_LEN + 1)
+static const uint16_t plc_ola_fade[PLC_OLA_LEN] = {
+      668,  1337,  2006,  2674,  3343,  4012,  4681,  5349,
+     6018,  6687,  7356,  8024,  8693,  9362, 10031, 10699,
+    11368, 12037, 12705, 13374, 14043, 14712, 15380, 16049,
+    16718, 17387, 18055, 18724, 19393, 20062, 20730, 21399,
+    22068, 22736, 23405, 24074, 24743, 25411, 26080, 26749,
+    27418, 28086, 28755, 29424, 30093, 30761, 31430, 32099,
+};
+
+void plc_init(plc_t *plc)
+{
+    memset(plc, 0, sizeof(plc_t));
+    plc->pitch = PLC_MIN_PITCH;
+}
+
+AUDIO_HOT static void plc_push_history(plc_t *plc, const audio_sample_t *frames, size_t len)
+{
+    if (len > PLC_HISTORY_LEN) {
+        frames += (len - PLC_HISTORY_LEN) * PLC_CH;
+        len = PLC_HISTORY_LEN;
+    }
+    size_t first = PLC_HISTORY_LEN - plc->head;
+    if (first > len)
+        first = len;
+    memcpy(&plc->history[plc->head * PLC_CH], frames, first * PLC_CH * sizeof(audio_sample_t));
+    memcpy(plc->history, frames + first * PLC_CH, (len - first) * PLC_CH * sizeof(audio_sample_t));
+    plc->head = (plc->head + len) & PLC_HISTORY_MASK;
+}
+
+// Frame n of the history in time order, 0 the oldest
+static inline const audio_sample_t *plc_history_frame(const plc_t *plc, uint32_t n)
+{
+    return &plc->history[((plc->head + n) & PLC_HISTORY_MASK) * PLC_CH];
+}
+
+// Normalised correlation score c * |c| / e, signals pre-scaled to 12 bits so
+// the products fit in 64 bits
+AUDIO_HOT static int64_t plc_score(const int16_t *target, int lag, int n)
+{
+    int64_t c = 0;
+    int64_t e = 1;
+    for (int i = 0; i < n; i++) {
+        int32_t a = target[i] >> 4;
+        int32_t b = target[i - lag] >> 4;
+        c += a * b;
+        e += b * b;
+    }
+
+    return (c > 0 ? c * c : -c * c) / e;
+}
+
+AUDIO_HOT static uint32_t plc_estimate_pitch(plc_t *plc)
+{
+    // Unroll the circular history, oldest first
+    for (int i = 0; i < PLC_HISTORY_LEN; i++) {
+        const audio_sample_t *h = plc_history_frame(plc, i);
+#if PLC_CH == 2
+        plc->mono[i] = (AUDIO_SAMPLE_TO_I16(h[0]) + AUDIO_SAMPLE_TO_I16(h[1])) >> 1;
+#else
+        plc->mono[i] = AUDIO_SAMPLE_TO_I16(h[0]);
+#endif
+    }
+
+    // Coarse search on a decimated copy, then refine at full rate
+    int16_t dec[PLC_HISTORY_LEN / PLC_DECIMATION];
+    for (int i = 0; i < PLC_HISTORY_LEN / PLC_DECIMATION; i++) {
+        const int16_t *h = &plc->mono[i * PLC_DECIMATION];
+        dec[i] = (h[0] + h[1] + h[2] + h[3]) >> 2;
+    }
+
+    const int dec_len = PLC_HISTORY_LEN / PLC_DECIMATION;
+    const int dec_window = PLC_WINDOW / PLC_DECIMATION;
+    const int16_t *dec_target = &dec[dec_len - dec_window];
+    int best_lag = PLC_MIN_PITCH / PLC_DECIMATION;
+    int64_t best = INT64_MIN;
+    for (int lag = PLC_MIN_PITCH / PLC_DECIMATION; lag <= PLC_MAX_PITCH / PLC_DECIMATION; lag++) {
+        int64_t score = plc_score(dec_target, lag, dec_window);
+        if (score > best) {
+            best = score;
+            best_lag = lag;
+        }
+    }
+
+    const int16_t *target = &plc->mono[PLC_HISTORY_LEN - PLC_WINDOW];
+    int centre = best_lag * PLC_DECIMATION;
+    int pitch = centre;
+    best = INT64_MIN;
+    for (int lag = centre - PLC_REFINE; lag <= centre + PLC_REFINE; lag++) {
+        if (lag < PLC_MIN_PITCH || lag > PLC_MAX_PITCH)
+            continue;
+        int64_t score = plc_score(target, lag, PLC_WINDOW);
+        if (score > best) {
+            best = score;
+            pitch = lag;
+        }
+    }
+
+    return pitch;
+}
+
+AUDIO_HOT static void plc_start(plc_t *plc)
+{
+    plc->pitch = plc_estimate_pitch(plc);
+    plc->pos = 0;
+    plc->concealed = 0;
+    plc->concealing = true;
+
+    // The loop restarts at history[N - P] after history[N - 1]: fade the end
+    // of the period into the samples one period earlier, which lead into
+    // history[N - P] naturally. Frames are fetched by time index, the period
+    // before can start ahead of the oldest frame for pitches over N / 2.
+    const uint32_t start = PLC_HISTORY_LEN - plc->pitch;
+    for (uint32_t i = 0; i < plc->pitch; i++) {
+        const audio_sample_t *h = plc_history_frame(plc, start + i);
+        for (int c = 0; c < PLC_CH; c++)
+            plc->period[i * PLC_CH + c] = h[c];
+    }
+    for (int i = 0; i < PLC_OLA_LEN; i++) {
+        const audio_sample_t *last = plc_history_frame(plc, PLC_HISTORY_LEN - PLC_OLA_LEN + i);
+        const audio_sample_t *prev = plc_history_frame(plc, PLC_HISTORY_LEN - 2 * plc->pitch + plc->pitch - PLC_OLA_LEN + i);
+        int k = (plc->pitch - PLC_OLA_LEN + i) * PLC_CH;
+        int32_t w = plc_ola_fade[i];
+        for (int c = 0; c < PLC_CH; c++)
+            plc->period[k + c] = ((plc_acc_t)last[c] * (32768 - w) + (plc_acc_t)prev[c] * w) >> 15;
+    }
+}
+
+// Next concealment frame including the decay envelope
+AUDIO_HOT static void plc_next(plc_t *plc, audio_sample_t *out)
+{
+    const audio_sample_t *frame = &plc->period[plc->pos * PLC_CH];
+    if (++plc->pos >= plc->pitch)
+        plc->pos = 0;
+
+    uint32_t decayed = plc->concealed > PLC_HOLD_LEN ? plc->concealed - PLC_HOLD_LEN : 0;
+    plc->concealed++;
+    if (decayed == 0) {
+        for (int c = 0; c < PLC_CH; c++)
+            out[c] = frame[c];
+        return;
+    }
+
+    // One Q15 level per frame from the decay frames left
+    int32_t level = decayed >= PLC_DECAY_LEN ? 0 : ((PLC_DECAY_LEN - decayed) * PLC_DECAY_SCALE) >> 16;
+    for (int c = 0; c < PLC_CH; c++)
+        out[c] = ((plc_acc_t)frame[c] * level) >> 15;
+}
+
+AUDIO_HOT void plc_conceal(plc_t *plc, audio_sample_t *out, size_t len)
+{
+    if (!plc->concealing)
+        plc_start(plc);
+
+    for (size_t i = 0; i < len; i++)
+        plc_next(plc, &out[i * PLC_CH]);
+
+    plc_push_history(plc, out, len);
+}
+
+AUDIO_HOT void plc_good_frame(plc_t *plc, audio_sample_t *frame, size_t len)
+{
+    if (plc->concealing) {
+        plc->concealing = false;
+        for (size_t i = 0; i < len && i < PLC_OLA_LEN; i++) {
+            audio_sample_t conceal[PLC_CH];
+            int32_t w = plc_ola_fade[i];
+            plc_next(plc, conceal);
+            for (int c = 0; c < PLC_CH; c++) {
+                audio_sample_t *s = &frame[i * PLC_CH + c];
+                *s = ((plc_acc_t)*s * w + (plc_acc_t)conceal[c] * (32768 - w)) >> 15;
+            }
+        }
+    }
+
+    plc_push_history(plc, frame, len);
+}
@@ -0,0 +1,54 @@
+#ifndef __PLC_H__
+#define __PLC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "audio_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLC_HISTORY_LEN     1024                // Frames of past output kept for pitch search
+#define PLC_MIN_PITCH       120                 // 2.5 ms at 48 kHz
+#define PLC_MAX_PITCH       720                 // 15 ms at 48 kHz
+#define PLC_OLA_LEN         48                  // Crossfade at the period seam and on recovery
+#define PLC_HOLD_LEN        (48 * 10)           // Full level concealment before decaying
+#define PLC_DECAY_LEN       (48 * 50)           // Decay to silence after the hold
+
+/*
+ * Packet loss concealment by pitch-period waveform repetition, all fixed
+ * point. When a frame is lost the pitch period of the recent output is
+ * estimated and the last period is repeated, with its end overlap-added
+ * onto the period before so the loop seam is smooth. After PLC_HOLD_LEN
+ * frames the repetition decays linearly to silence. The first real frame
+ * after a gap is crossfaded in from the continuing concealment.
+ *
+ * Works on frames of AUDIO_CHANNELS sink samples. The pitch is searched on a
+ * 16-bit mono downmix and applied to every channel.
+ */
+typedef struct {
+    audio_sample_t history[PLC_HISTORY_LEN * AUDIO_CHANNELS];   // Last output frames, circular
+    audio_sample_t period[PLC_MAX_PITCH * AUDIO_CHANNELS];      // Loop being repeated
+    int16_t mono[PLC_HISTORY_LEN];              // Downmix of history in time order for the pitch search
+    uint32_t head;                              // Oldest history frame, next written
+    uint32_t pitch;                             // Frames
+    uint32_t pos;                               // Position in period
+    uint32_t concealed;                         // Frames concealed in the current gap
+    bool concealing;
+} plc_t;
+
+void plc_init(plc_t* plc);
+
+// Passes len received frames through, crossfading them in if they end a gap
+void plc_good_frame(plc_t* plc, audio_sample_t* frame, size_t len);
+
+// Synthesises len frames in place of lost audio
+void plc_conceal(plc_t* plc, audio_sample_t* out, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __PLC_H__
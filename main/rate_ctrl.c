@@ -0,0 +1,143 @@
+#include "rate_ctrl.h"
+#include <string.h>
+
+// MAC header, FCS, action category, OUI, random and the vendor element
+// ESP-NOW wraps its data in
+#define RATE_FRAME_OVERHEAD     (24 + 4 + 1 + 3 + 4 + 7)
+
+static const uint32_t rate_kbps[RATE_COUNT] = {
+    6000, 9000, 12000, 18000, 24000, 36000, 48000, 54000,
+};
+
+uint32_t rate_ctrl_kbps(rate_t rate)
+{
+    return rate_kbps[rate];
+}
+
+uint32_t rate_ctrl_airtime_us(rate_t rate, uint32_t bytes)
+{
+    // Preamble and SIGNAL, then 4 us symbols carrying SERVICE, data and tail
+    uint32_t bits = 16 + 8 * (bytes + RATE_FRAME_OVERHEAD) + 6;
+    uint32_t bits_per_symbol = rate_kbps[rate] * 4 / 1000;
+    return 20 + 4 * ((bits + bits_per_symbol - 1) / bits_per_symbol);
+}
+
+static bool rate_fits(const rate_ctrl_t *ctrl, rate_t rate)
+{
+    return (uint64_t)rate_ctrl_airtime_us(rate, ctrl->bytes) * ctrl->packets_per_s <= RATE_AIRTIME_MAX * 1000;
+}
+
+// Airtime per delivered packet, scaled
+static uint32_t rate_cost(const rate_ctrl_t *ctrl, rate_t rate, uint32_t prob)
+{
+    return rate_ctrl_airtime_us(rate, ctrl->bytes) * 1000 / (prob ? prob : 1);
+}
+
+static void rate_use(rate_ctrl_t *ctrl, rate_t rate)
+{
+    if (rate != ctrl->current)
+        ctrl->stats.changes++;
+    ctrl->current = ctrl->active = rate;
+}
+
+void rate_ctrl_init(rate_ctrl_t *ctrl, rate_t start, int64_t now_ms)
+{
+    memset(ctrl, 0, sizeof(rate_ctrl_t));
+    for (int i = 0; i < RATE_COUNT; i++)
+        ctrl->rates[i].backoff = RATE_SAMPLE_REPORTS;
+    ctrl->current = ctrl->active = start;
+    ctrl->bytes = 250;
+    ctrl->report_ms = now_ms;
+}
+
+void rate_ctrl_set_load(rate_ctrl_t *ctrl, uint32_t bytes, uint32_t packets_per_s)
+{
+    ctrl->bytes = bytes;
+    ctrl->packets_per_s = packets_per_s;
+}
+
+// Fastest rate below the current one that still delivers, by its stats or
+// for want of any
+static rate_t rate_step_down(const rate_ctrl_t *ctrl)
+{
+    rate_t best = ctrl->current;
+    uint32_t best_cost = UINT32_MAX;
+    for (int i = ctrl->current - 1; i >= 0; i--) {
+        const rate_stats_t *stats = &ctrl->rates[i];
+        uint32_t prob = stats->windows ? stats->prob : 1000;
+        if (prob < RATE_PROB_MIN || !rate_fits(ctrl, i))
+            continue;
+        uint32_t cost = rate_cost(ctrl, i, prob);
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = i;
+        }
+    }
+    if (best == ctrl->current && ctrl->current > 0 && rate_fits(ctrl, ctrl->current - 1))
+        best = ctrl->current - 1;
+    return best;
+}
+
+static void rate_window(rate_ctrl_t *ctrl, uint32_t delivery)
+{
+    rate_stats_t *stats = &ctrl->rates[ctrl->active];
+    stats->prob = stats->windows ? (stats->prob + delivery) / 2 : delivery;
+    stats->windows++;
+    ctrl->stats.windows++;
+
+    if (ctrl->active != ctrl->current) {
+        // A sample decides on its own window, the smoothing is for the
+        // rate in use
+        if (delivery >= RATE_PROB_MIN && rate_cost(ctrl, ctrl->active, delivery) <
+                                             rate_cost(ctrl, ctrl->current, ctrl->rates[ctrl->current].prob)) {
+            stats->backoff = RATE_SAMPLE_REPORTS;
+            rate_use(ctrl, ctrl->active);
+        } else {
+            if (stats->backoff < RATE_SAMPLE_BACKOFF_MAX)
+                stats->backoff *= 2;
+            ctrl->active = ctrl->current;
+        }
+        return;
+    }
+
+    if (stats->prob < RATE_PROB_MIN || delivery < RATE_PROB_MIN / 2) {
+        rate_use(ctrl, rate_step_down(ctrl));
+        ctrl->since_sample = 0;
+        return;
+    }
+
+    rate_t faster = ctrl->current + 1;
+    if (faster < RATE_COUNT && rate_fits(ctrl, faster) && ++ctrl->since_sample >= ctrl->rates[faster].backoff) {
+        ctrl->since_sample = 0;
+        ctrl->active = faster;
+        ctrl->stats.samples++;
+    }
+}
+
+rate_t rate_ctrl_report(rate_ctrl_t *ctrl, uint32_t received, uint32_t expected, uint32_t sent,
+                        uint32_t failed, int64_t now_ms)
+{
+    ctrl->report_ms = now_ms;
+    if (expected == 0)
+        return ctrl->active;
+
+    // Failed sends are missing at the receiver too, so take the worse of
+    // the two rather than counting them twice
+    uint32_t delivery = received < expected ? (uint64_t)received * 1000 / expected : 1000;
+    if (sent > 0 && failed > 0) {
+        uint32_t went_out = failed < sent ? (uint64_t)(sent - failed) * 1000 / sent : 0;
+        if (went_out < delivery)
+            delivery = went_out;
+    }
+    rate_window(ctrl, delivery);
+    return ctrl->active;
+}
+
+rate_t rate_ctrl_tick(rate_ctrl_t *ctrl, int64_t now_ms)
+{
+    if (now_ms - ctrl->report_ms >= RATE_SILENCE_MS) {
+        ctrl->report_ms = now_ms;
+        rate_window(ctrl, 0);
+    }
+    return ctrl->active;
+}
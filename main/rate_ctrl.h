@@ -0,0 +1,90 @@
+#ifndef __RATE_CTRL_H__
+#define __RATE_CTRL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RATE_PROB_MIN           980     // Delivery, permille, a rate must keep to be used
+#define RATE_SAMPLE_REPORTS     8       // Reports between samples of the next faster rate
+#define RATE_SAMPLE_BACKOFF_MAX 128     // Reports, a rate failing its samples is tried ever less often
+#define RATE_AIRTIME_MAX        500     // Permille of the air a rate may need for the stream
+#define RATE_SILENCE_MS         1000    // No report for this long while sending counts as a lost window
+
+// The OFDM rates ESP-NOW can send at
+typedef enum {
+    RATE_6M,
+    RATE_9M,
+    RATE_12M,
+    RATE_18M,
+    RATE_24M,
+    RATE_36M,
+    RATE_48M,
+    RATE_54M,
+    RATE_COUNT,
+} rate_t;
+
+typedef struct {
+    uint32_t prob;                          // Smoothed delivery, permille
+    uint32_t windows;                       // Windows measured, prob is a guess while 0
+    uint32_t backoff;                       // Reports between samples of this rate
+} rate_stats_t;
+
+typedef struct {
+    uint32_t windows;
+    uint32_t samples;
+    uint32_t changes;
+} rate_ctrl_stats_t;
+
+/*
+ * Picks the PHY rate with the least airtime per delivered packet among the
+ * rates delivering at least RATE_PROB_MIN, like Minstrel but per window
+ * instead of per packet: broadcast frames are never acked, so delivery is
+ * only known from receiver reports. Each report closes a window at the rate
+ * in use and updates that rate's smoothed delivery.
+ *
+ * Every RATE_SAMPLE_REPORTS reports one window is sent at the next faster
+ * rate; if it delivers and costs less airtime it is kept. A failed sample
+ * doubles that rate's sampling interval, so a link at its limit loses one
+ * window now and then instead of every few seconds. A window delivering
+ * below RATE_PROB_MIN steps down at once. Rates needing more than
+ * RATE_AIRTIME_MAX of the air for the stream are never used.
+ */
+typedef struct {
+    rate_stats_t rates[RATE_COUNT];
+    rate_t current;                         // Rate picked from the stats
+    rate_t active;                          // Rate in use, the sample rate while sampling
+    uint32_t since_sample;
+    uint32_t bytes;                         // Average frame, for airtime
+    uint32_t packets_per_s;
+    int64_t report_ms;
+    rate_ctrl_stats_t stats;
+} rate_ctrl_t;
+
+void rate_ctrl_init(rate_ctrl_t* ctrl, rate_t start, int64_t now_ms);
+
+// Stream the airtime is worked out for
+void rate_ctrl_set_load(rate_ctrl_t* ctrl, uint32_t bytes, uint32_t packets_per_s);
+
+// Closes a window. received and expected come from a receiver report, sent
+// and failed from the send callbacks over the same time. Returns the rate
+// for the next window.
+rate_t rate_ctrl_report(rate_ctrl_t* ctrl, uint32_t received, uint32_t expected, uint32_t sent,
+                        uint32_t failed, int64_t now_ms);
+
+// Called periodically while sending, steps down when the reports stop.
+rate_t rate_ctrl_tick(rate_ctrl_t* ctrl, int64_t now_ms);
+
+uint32_t rate_ctrl_kbps(rate_t rate);
+
+// Time on air of one ESP-NOW frame with bytes of ESP-NOW data, in us
+uint32_t rate_ctrl_airtime_us(rate_t rate, uint32_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RATE_CTRL_H__
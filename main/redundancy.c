@@ -0,0 +1,95 @@
+#include "redundancy.h"
+#include <string.h>
+
+// Loss on the air, in permille, each level still plays through cleanly.
+// FEC repairs one packet per group, so its residual loss grows with the
+// square of the channel's; a copy needs both sends lost.
+static const uint32_t redundancy_copes[REDUNDANCY_LEVELS] = {
+    [REDUNDANCY_NONE] = 5,
+    [REDUNDANCY_FEC] = 20,
+    [REDUNDANCY_COPY1] = 80,
+    [REDUNDANCY_COPY2] = UINT32_MAX,
+};
+
+static const char *const redundancy_names[REDUNDANCY_LEVELS] = {
+    [REDUNDANCY_NONE] = "none",
+    [REDUNDANCY_FEC] = "FEC",
+    [REDUNDANCY_COPY1] = "1 copy",
+    [REDUNDANCY_COPY2] = "2 copies",
+};
+
+static redundancy_level_t redundancy_step(const redundancy_ctrl_t *ctrl, redundancy_level_t level, int dir)
+{
+    level += dir;
+    if (level == REDUNDANCY_FEC && !ctrl->fec)
+        level += dir;
+    return level;
+}
+
+void redundancy_init(redundancy_ctrl_t *ctrl, redundancy_level_t start, bool fec)
+{
+    memset(ctrl, 0, sizeof(redundancy_ctrl_t));
+    ctrl->fec = fec;
+    ctrl->level = start == REDUNDANCY_FEC && !fec ? REDUNDANCY_COPY1 : start;
+}
+
+redundancy_level_t redundancy_update(redundancy_ctrl_t *ctrl, uint32_t received, uint32_t expected,
+                                     uint32_t lost)
+{
+    if (expected == 0)
+        return ctrl->level;
+
+    ctrl->stats.reports++;
+    uint32_t loss = received < expected ? (uint64_t)(expected - received) * 1000 / expected : 0;
+    uint32_t residual = (uint64_t)lost * 1000 / expected;
+
+    // Smoothed over roughly four reports
+    ctrl->loss_avg += (int32_t)((loss << 4) - ctrl->loss_avg) / 4;
+
+    // One report far over, or the average over, what the level copes with.
+    // A single report only just over is mostly the noise of a few packets.
+    uint32_t copes = redundancy_copes[ctrl->level];
+    if (ctrl->level < REDUNDANCY_COPY2 &&
+        (loss > 2 * copes || ctrl->loss_avg > copes << 4 || residual > REDUNDANCY_RESIDUAL_UP)) {
+        ctrl->level = redundancy_step(ctrl, ctrl->level, 1);
+        ctrl->clean_reports = 0;
+        // Start from this report, not the calm before it
+        if (ctrl->loss_avg < loss << 4)
+            ctrl->loss_avg = loss << 4;
+        ctrl->stats.raises++;
+        return ctrl->level;
+    }
+
+    if (ctrl->level == REDUNDANCY_NONE)
+        return ctrl->level;
+
+    redundancy_level_t lower = redundancy_step(ctrl, ctrl->level, -1);
+    if (ctrl->loss_avg < (redundancy_copes[lower] << 4) / 2 && residual == 0) {
+        if (++ctrl->clean_reports >= REDUNDANCY_HOLD_REPORTS) {
+            ctrl->level = lower;
+            ctrl->clean_reports = 0;
+            ctrl->stats.drops++;
+        }
+    } else {
+        ctrl->clean_reports = 0;
+    }
+
+    return ctrl->level;
+}
+
+uint8_t redundancy_copies(redundancy_level_t level)
+{
+    switch (level) {
+    case REDUNDANCY_COPY1:
+        return 1;
+    case REDUNDANCY_COPY2:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+const char *redundancy_level_name(redundancy_level_t level)
+{
+    return level < REDUNDANCY_LEVELS ? redundancy_names[level] : "?";
+}
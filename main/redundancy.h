@@ -0,0 +1,62 @@
+#ifndef __REDUNDANCY_H__
+#define __REDUNDANCY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define REDUNDANCY_HOLD_REPORTS     8       // Clean reports in a row before stepping down
+#define REDUNDANCY_RESIDUAL_UP      10      // Permille still lost at playout that steps up regardless
+
+typedef enum {
+    REDUNDANCY_NONE,                        // Each packet once
+    REDUNDANCY_FEC,                         // One XOR parity packet per ESPNOW_FEC_K
+    REDUNDANCY_COPY1,                       // Each packet twice
+    REDUNDANCY_COPY2,                       // Each packet three times
+    REDUNDANCY_LEVELS,
+} redundancy_level_t;
+
+typedef struct {
+    uint32_t raises;
+    uint32_t drops;
+    uint32_t reports;
+} redundancy_stats_t;
+
+/*
+ * Picks the redundancy level from receiver reports of the loss on the air.
+ * Each level has a loss it copes with; a single report at twice that, or
+ * the smoothed loss above it, steps up at once, while stepping down takes
+ * REDUNDANCY_HOLD_REPORTS reports in a row with the smoothed loss under
+ * half of what the lower level copes with. The gap keeps a channel sitting near a threshold from flapping
+ * between levels. Several receivers simply all feed the same controller:
+ * the worst one keeps the level up. Integer only, so recorded loss traces
+ * can be replayed through it on a host.
+ */
+typedef struct {
+    redundancy_level_t level;
+    uint32_t loss_avg;                      // Permille << 4, smoothed over reports
+    uint32_t clean_reports;
+    bool fec;                               // REDUNDANCY_FEC may be used
+    redundancy_stats_t stats;
+} redundancy_ctrl_t;
+
+void redundancy_init(redundancy_ctrl_t* ctrl, redundancy_level_t start, bool fec);
+
+// Feeds one report: audio packets received and expected on the air, and
+// packets still lost at playout. Returns the level to send with.
+redundancy_level_t redundancy_update(redundancy_ctrl_t* ctrl, uint32_t received, uint32_t expected,
+                                     uint32_t lost);
+
+// Extra copies sent of each packet at a level
+uint8_t redundancy_copies(redundancy_level_t level);
+
+const char* redundancy_level_name(redundancy_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __REDUNDANCY_H__
@@ -0,0 +1,184 @@
+#include "resample.h"
+#include <math.h>
+#include <string.h>
+
+#define RESAMPLE_HALF           (RESAMPLE_TAPS / 2)
+#define RESAMPLE_KAISER_BETA    7.0f            // About 70 dB of stopband for 48 taps
+
+#if AUDIO_BYTES_PER_SAMPLE == 4
+typedef int64_t resample_acc_t;
+#define RESAMPLE_SAMPLE_MAX     INT32_MAX
+#define RESAMPLE_SAMPLE_MIN     INT32_MIN
+#else
+typedef int32_t resample_acc_t;
+#define RESAMPLE_SAMPLE_MAX     INT16_MAX
+#define RESAMPLE_SAMPLE_MIN     INT16_MIN
+#endif
+
+typedef struct {
+    uint32_t in_rate;                           // 0 while free
+    uint32_t out_rate;
+    int16_t coefs[RESAMPLE_MAX_PHASES / 2 + 1][RESAMPLE_TAPS];
+} resample_table_t;
+
+static resample_table_t resample_tables[RESAMPLE_TABLES];
+
+static uint32_t resample_gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth order modified Bessel function, for the Kaiser window
+static float resample_bessel_i0(float x)
+{
+    float sum = 1, term = 1;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-9f)
+            break;
+    }
+    return sum;
+}
+
+static void resample_make_coefs(resample_table_t *table, uint32_t in_rate, uint32_t out_rate)
+{
+    uint32_t up = out_rate / resample_gcd(in_rate, out_rate);
+    // Cycles per input frame, half the lower rate
+    float cutoff = (float)(in_rate < out_rate ? in_rate : out_rate) / (2.0f * in_rate);
+    float norm = resample_bessel_i0(RESAMPLE_KAISER_BETA);
+
+    for (uint32_t p = 0; p <= up / 2; p++) {
+        float taps[RESAMPLE_TAPS];
+        float sum = 0;
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            float t = k - (RESAMPLE_HALF - 1) - (float)p / up;
+            float x = 2 * cutoff * t;
+            float sinc = t == 0 ? 1 : sinf(M_PI * x) / (M_PI * x);
+            float r = t / RESAMPLE_HALF;
+            float kaiser = r * r < 1 ? resample_bessel_i0(RESAMPLE_KAISER_BETA * sqrtf(1 - r * r)) / norm : 0;
+            taps[k] = sinc * kaiser;
+            sum += taps[k];
+        }
+        // Unity gain at DC before rounding only: over this many taps, moving
+        // the rounding error onto one tap the way asrc does skews each
+        // phase's delay and costs about 3 dB of SNR
+        for (int k = 0; k < RESAMPLE_TAPS; k++)
+            table->coefs[p][k] = lrintf(taps[k] / sum * (1 << RESAMPLE_COEF_SHIFT));
+    }
+    table->in_rate = in_rate;
+    table->out_rate = out_rate;
+}
+
+static resample_table_t *resample_find_table(uint32_t in_rate, uint32_t out_rate)
+{
+    for (int i = 0; i < RESAMPLE_TABLES; i++) {
+        if (resample_tables[i].in_rate == in_rate && resample_tables[i].out_rate == out_rate)
+            return &resample_tables[i];
+    }
+    return NULL;
+}
+
+bool resample_prepare(uint32_t in_rate, uint32_t out_rate)
+{
+    if (in_rate == 0 || out_rate == 0)
+        return false;
+    if (out_rate / resample_gcd(in_rate, out_rate) > RESAMPLE_MAX_PHASES)
+        return false;
+    // Taking more input frames per output than a call can hold
+    if ((uint64_t)RESAMPLE_MAX_FRAMES * in_rate / out_rate + 2 > RESAMPLE_MAX_IN)
+        return false;
+    if (resample_find_table(in_rate, out_rate) != NULL)
+        return true;
+
+    resample_table_t *free_table = resample_find_table(0, 0);
+    if (free_table == NULL)
+        return false;
+    resample_make_coefs(free_table, in_rate, out_rate);
+    return true;
+}
+
+bool resample_init(resample_t *rs, uint32_t in_rate, uint32_t out_rate)
+{
+    memset(rs, 0, sizeof(resample_t));
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    if (in_rate == out_rate)
+        return true;
+    if (!resample_prepare(in_rate, out_rate))
+        return false;
+
+    uint32_t gcd = resample_gcd(in_rate, out_rate);
+    rs->up = out_rate / gcd;
+    rs->down = in_rate / gcd;
+    rs->coefs = (const int16_t (*)[RESAMPLE_TAPS])resample_find_table(in_rate, out_rate)->coefs;
+    // Silence as history, as if the last call had moved on one frame
+    rs->kept = RESAMPLE_TAPS - 1;
+    return true;
+}
+
+AUDIO_HOT size_t resample_input_frames(const resample_t *rs, size_t out_frames)
+{
+    if (out_frames == 0)
+        return 0;
+    // Frames the window moves on before the last output, plus the window
+    // that output needs, minus what is still held from the last call
+    size_t moved = (rs->phase + (out_frames - 1) * rs->down) / rs->up;
+    return RESAMPLE_TAPS + moved - rs->kept;
+}
+
+AUDIO_HOT static audio_sample_t resample_saturate(resample_acc_t acc)
+{
+    acc = (acc + (1 << (RESAMPLE_COEF_SHIFT - 1))) >> RESAMPLE_COEF_SHIFT;
+    if (acc > RESAMPLE_SAMPLE_MAX)
+        return RESAMPLE_SAMPLE_MAX;
+    if (acc < RESAMPLE_SAMPLE_MIN)
+        return RESAMPLE_SAMPLE_MIN;
+    return acc;
+}
+
+AUDIO_HOT void resample_process(resample_t *rs, const audio_sample_t *in, audio_sample_t *out, size_t out_frames)
+{
+    size_t in_frames = resample_input_frames(rs, out_frames);
+    memcpy(&rs->buf[rs->kept * AUDIO_CHANNELS], in, in_frames * AUDIO_CHANNELS * sizeof(audio_sample_t));
+    size_t total = rs->kept + in_frames;
+
+    uint32_t phase = rs->phase;
+    size_t pos = 0;                             // First frame of the window
+    for (size_t j = 0; j < out_frames; j++) {
+        // Phase up - p is phase p backwards
+        const int16_t *c;
+        int stride;
+        if (phase <= rs->up / 2) {
+            c = rs->coefs[phase];
+            stride = 1;
+        } else {
+            c = &rs->coefs[rs->up - phase][RESAMPLE_TAPS - 1];
+            stride = -1;
+        }
+
+        const audio_sample_t *x = &rs->buf[pos * AUDIO_CHANNELS];
+        for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+            resample_acc_t acc = 0;
+            for (int k = 0; k < RESAMPLE_TAPS; k++)
+                acc += (resample_acc_t)c[k * stride] * x[k * AUDIO_CHANNELS + ch];
+            *out++ = resample_saturate(acc);
+        }
+
+        phase += rs->down;
+        while (phase >= rs->up) {
+            phase -= rs->up;
+            pos++;
+        }
+    }
+    rs->phase = phase;
+
+    // Keep the next output's window
+    rs->kept = total - pos;
+    memmove(rs->buf, &rs->buf[pos * AUDIO_CHANNELS], rs->kept * AUDIO_CHANNELS * sizeof(audio_sample_t));
+}
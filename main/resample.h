@@ -0,0 +1,71 @@
+#ifndef __RESAMPLE_H__
+#define __RESAMPLE_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "audio_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESAMPLE_TAPS           48              // Per phase, in input frames
+#define RESAMPLE_COEF_SHIFT     14              // Q14 coefficients leave headroom in the 32-bit sum
+#define RESAMPLE_MAX_PHASES     160             // 44.1 and 48 kHz reduce to 147 and 160
+#define RESAMPLE_TABLES         2               // Ratios with a table at once, both directions
+#define RESAMPLE_MAX_FRAMES     96              // Output frames per call
+#define RESAMPLE_MAX_IN         (RESAMPLE_MAX_FRAMES * 160 / 147 + 2)
+
+/*
+ * Fixed ratio polyphase resampler between two sample rates, 48 kHz to
+ * 44.1 kHz and back: the ratio reduces to up / down, 147 / 160 or
+ * 160 / 147, and output frame n sits n * down / up input frames along, so
+ * each output filters the input with one of up phases of a Kaiser windowed
+ * sinc. The cutoff is half the lower rate: aliases and images of anything
+ * up to 20 kHz land above 20 kHz.
+ *
+ * The phases of a symmetric filter mirror each other, so only the first
+ * half is stored and the rest read backwards. Tables are built in float
+ * the first time a ratio is used; resample_prepare builds one ahead so
+ * resample_init is cheap enough for the audio path.
+ *
+ * Call resample_input_frames, read exactly that many frames, then
+ * resample_process. Not thread safe, one instance per stream.
+ */
+typedef struct {
+    audio_sample_t buf[(RESAMPLE_TAPS + RESAMPLE_MAX_IN) * AUDIO_CHANNELS];
+    size_t kept;                                // Frames at the start of buf from the previous call
+    uint32_t up;                                // Phases, output frames per down input frames
+    uint32_t down;
+    uint32_t phase;                             // Of the next output, 0..up-1
+    uint32_t in_rate;
+    uint32_t out_rate;
+    const int16_t (*coefs)[RESAMPLE_TAPS];      // Phases 0..up/2
+} resample_t;
+
+// Builds the table for a ratio, false if it is too fine or the tables are
+// all taken. Slow, float.
+bool resample_prepare(uint32_t in_rate, uint32_t out_rate);
+
+// Starts from silence at the given rates, false if the ratio is not
+// supported. Equal rates leave the resampler inactive.
+bool resample_init(resample_t* rs, uint32_t in_rate, uint32_t out_rate);
+
+// Whether the rates differ, an inactive resampler must not be used
+static inline bool resample_active(const resample_t* rs)
+{
+    return rs->coefs != NULL;
+}
+
+// Frames resample_process will consume to produce out_frames
+size_t resample_input_frames(const resample_t* rs, size_t out_frames);
+
+// Resamples resample_input_frames(out_frames) frames of in into out
+void resample_process(resample_t* rs, const audio_sample_t* in, audio_sample_t* out, size_t out_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RESAMPLE_H__
@@ -0,0 +1,174 @@
+#include "ringbuf_bcast.h"
+#include <assert.h>
+#include <string.h>
+
+#define RINGBUF_BCAST_MASK(val) ((val) & (RINGBUF_BCAST_CAPACITY - 1))
+
+/*
+ * The writer publishes claim before touching the buffer and write after it,
+ * seqlock style. A reader copies out first and checks claim afterwards: if
+ * the writer may have reached the copied span in the meantime, the copy is
+ * thrown away and the reader resynchronises.
+ */
+
+void ringbuf_bcast_reset(ringbuf_bcast_t *rbuf)
+{
+    assert(rbuf);
+
+    atomic_init(&rbuf->write, 0);
+    atomic_init(&rbuf->claim, 0);
+    atomic_init(&rbuf->n_readers, 0);
+    for (int i = 0; i < RINGBUF_BCAST_MAX_READERS; i++) {
+        atomic_init(&rbuf->readers[i].read, 0);
+        rbuf->readers[i].active = false;
+        rbuf->readers[i].underruns = 0;
+        rbuf->readers[i].overruns = 0;
+    }
+}
+
+int ringbuf_bcast_add_reader(ringbuf_bcast_t *rbuf)
+{
+    int reader = atomic_fetch_add(&rbuf->n_readers, 1);
+    if (reader >= RINGBUF_BCAST_MAX_READERS) {
+        atomic_fetch_sub(&rbuf->n_readers, 1);
+        return -1;
+    }
+
+    return reader;
+}
+
+//--------------------------------------------------------------------+
+// Writer
+//--------------------------------------------------------------------+
+
+AUDIO_HOT void ringbuf_bcast_write(ringbuf_bcast_t *rbuf, const audio_sample_t *buf, size_t size)
+{
+    if (size > RINGBUF_BCAST_CAPACITY) {
+        buf += size - RINGBUF_BCAST_CAPACITY;
+        size = RINGBUF_BCAST_CAPACITY;
+    }
+
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    atomic_store_explicit(&rbuf->claim, write + size, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    uint32_t start = RINGBUF_BCAST_MASK(write);
+    size_t first = RINGBUF_BCAST_CAPACITY - start;
+    if (first > size)
+        first = size;
+    memcpy(&rbuf->buffer[start], buf, first * sizeof(audio_sample_t));
+    memcpy(rbuf->buffer, buf + first, (size - first) * sizeof(audio_sample_t));
+
+    atomic_store_explicit(&rbuf->write, write + size, memory_order_release);
+}
+
+//--------------------------------------------------------------------+
+// Reader
+//--------------------------------------------------------------------+
+
+// Jumps a lapped reader to the newest data
+AUDIO_HOT static void ringbuf_bcast_resync(ringbuf_bcast_t *rbuf, ringbuf_bcast_reader_t *r, uint32_t read)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    r->overruns += write - read;
+    atomic_store_explicit(&r->read, write, memory_order_relaxed);
+}
+
+void ringbuf_bcast_set_active(ringbuf_bcast_t *rbuf, int reader, bool active)
+{
+    assert(reader >= 0 && reader < RINGBUF_BCAST_MAX_READERS);
+    ringbuf_bcast_reader_t *r = &rbuf->readers[reader];
+
+    if (active) {
+        uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+        atomic_store_explicit(&r->read, write, memory_order_relaxed);
+    }
+    r->active = active;
+}
+
+AUDIO_HOT bool ringbuf_bcast_read_frames(ringbuf_bcast_t *rbuf, int reader, audio_sample_t *buf, size_t frames)
+{
+    assert(reader >= 0 && reader < RINGBUF_BCAST_MAX_READERS);
+    ringbuf_bcast_reader_t *r = &rbuf->readers[reader];
+    size_t size = frames * AUDIO_CHANNELS;
+
+    uint32_t read = atomic_load_explicit(&r->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+    if (count > RINGBUF_BCAST_CAPACITY) {
+        ringbuf_bcast_resync(rbuf, r, read);
+        r->underruns += size;
+        return false;
+    }
+    // Short: leave what is there to start the next read once the rest is in
+    if (size > count) {
+        r->underruns += size;
+        return false;
+    }
+
+    uint32_t start = RINGBUF_BCAST_MASK(read);
+    size_t first = RINGBUF_BCAST_CAPACITY - start;
+    if (first > size)
+        first = size;
+    memcpy(buf, &rbuf->buffer[start], first * sizeof(audio_sample_t));
+    memcpy(buf + first, rbuf->buffer, (size - first) * sizeof(audio_sample_t));
+
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t claim = atomic_load_explicit(&rbuf->claim, memory_order_relaxed);
+    if (claim - read > RINGBUF_BCAST_CAPACITY) {
+        ringbuf_bcast_resync(rbuf, r, read);
+        r->underruns += size;
+        return false;
+    }
+
+    atomic_store_explicit(&r->read, read + size, memory_order_relaxed);
+
+    return true;
+}
+
+size_t ringbuf_bcast_skip_to_latest(ringbuf_bcast_t *rbuf, int reader, size_t keep)
+{
+    assert(reader >= 0 && reader < RINGBUF_BCAST_MAX_READERS);
+    ringbuf_bcast_reader_t *r = &rbuf->readers[reader];
+
+    uint32_t read = atomic_load_explicit(&r->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+    if (count <= keep)
+        return 0;
+
+    atomic_store_explicit(&r->read, write - keep, memory_order_relaxed);
+
+    return count - keep;
+}
+
+AUDIO_HOT size_t ringbuf_bcast_size(ringbuf_bcast_t *rbuf, int reader)
+{
+    assert(reader >= 0 && reader < RINGBUF_BCAST_MAX_READERS);
+
+    uint32_t read = atomic_load_explicit(&rbuf->readers[reader].read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+
+    return count > RINGBUF_BCAST_CAPACITY ? RINGBUF_BCAST_CAPACITY : count;
+}
+
+//--------------------------------------------------------------------+
+// Either side
+//--------------------------------------------------------------------+
+
+size_t ringbuf_bcast_avail(ringbuf_bcast_t *rbuf)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t max_count = 0;
+    int n_readers = atomic_load(&rbuf->n_readers);
+    for (int i = 0; i < n_readers && i < RINGBUF_BCAST_MAX_READERS; i++) {
+        if (!rbuf->readers[i].active)
+            continue;
+        size_t count = write - atomic_load_explicit(&rbuf->readers[i].read, memory_order_relaxed);
+        if (count > max_count)
+            max_count = count;
+    }
+
+    return max_count >= RINGBUF_BCAST_CAPACITY ? 0 : RINGBUF_BCAST_CAPACITY - max_count;
+}
@@ -0,0 +1,91 @@
+#ifndef __RINGBUF_BCAST_H__
+#define __RINGBUF_BCAST_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "ringbuf_i16.h"
+#include "audio_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RINGBUF_BCAST_MAX_READERS   2
+#define RINGBUF_BCAST_CAPACITY      (RINGBUF_I16_CAPACITY * AUDIO_CHANNELS)     // Samples, whole frames
+
+/*
+ * Single-writer, multi-reader broadcast variant of ringbuf_i16 carrying
+ * sink samples (audio_sample_t). Every reader sees the whole stream through
+ * its own read cursor. The writer never waits
+ * for readers: a reader that falls more than RINGBUF_BCAST_CAPACITY samples
+ * behind is lapped, counts the lost samples as overruns and resumes from
+ * the newest data, so a slow sink cannot stall a fast one.
+ *
+ * Reads are whole frames and all or nothing: a sink always gets the full
+ * packet it asked for, copied across the wrap if need be, or an underrun
+ * and nothing consumed, never a short packet.
+ *
+ * ringbuf_bcast_write must only be called from one task, and each reader
+ * must only be used from one task. Writes must be whole frames, multiples
+ * of AUDIO_CHANNELS samples, so every cursor stays frame aligned.
+ */
+typedef struct {
+    atomic_uint read;
+    bool active;
+    uint32_t underruns;                 // Samples of reads that found too few
+    uint32_t overruns;                  // Samples lost to the writer lapping this reader
+    uint8_t pad[RINGBUF_CACHE_LINE];
+} ringbuf_bcast_reader_t;
+
+typedef struct {
+    // Writer
+    atomic_uint write;                  // End of published samples
+    atomic_uint claim;                  // End of samples being written
+    uint8_t pad[RINGBUF_CACHE_LINE];
+
+    ringbuf_bcast_reader_t readers[RINGBUF_BCAST_MAX_READERS];
+    atomic_int n_readers;
+
+    audio_sample_t buffer[RINGBUF_BCAST_CAPACITY];
+} ringbuf_bcast_t;
+
+// Also initialises a statically allocated ring. Not thread safe, nothing
+// may be using it.
+void ringbuf_bcast_reset(ringbuf_bcast_t* rbuf);
+
+// Returns the new reader index, or -1 if RINGBUF_BCAST_MAX_READERS are in use.
+// Readers start inactive.
+int ringbuf_bcast_add_reader(ringbuf_bcast_t* rbuf);
+
+// Writer
+
+// Writes the newest RINGBUF_BCAST_CAPACITY samples of buf at most
+void ringbuf_bcast_write(ringbuf_bcast_t* rbuf, const audio_sample_t* buf, size_t size);
+
+// Reader
+
+// Activating a reader drops anything it had not read yet. Inactive readers
+// are left out of ringbuf_bcast_avail and do not count overruns.
+void ringbuf_bcast_set_active(ringbuf_bcast_t* rbuf, int reader, bool active);
+
+// Reads exactly frames frames, or returns false having read nothing if
+// fewer are waiting or the reader was lapped
+bool ringbuf_bcast_read_frames(ringbuf_bcast_t* rbuf, int reader, audio_sample_t* buf, size_t frames);
+
+// Discards all but the newest keep samples, returns the number discarded
+size_t ringbuf_bcast_skip_to_latest(ringbuf_bcast_t* rbuf, int reader, size_t keep);
+
+// Samples waiting for the reader
+size_t ringbuf_bcast_size(ringbuf_bcast_t* rbuf, int reader);
+
+// Either side
+
+// Free space before the furthest behind active reader gets lapped
+size_t ringbuf_bcast_avail(ringbuf_bcast_t* rbuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __RINGBUF_BCAST_H__
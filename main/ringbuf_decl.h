@@ -0,0 +1,116 @@
+/*
+ * Declares one member of the ring buffer family. Define the parameters and
+ * include this header; it may be included once per instance:
+ *
+ *   #define RINGBUF_NAME      ringbuf_i16     // prefix of the type and functions
+ *   #define RINGBUF_TYPE      int16_t         // element type
+ *   #define RINGBUF_CAPACITY  1024            // elements, power of two
+ *   #include "ringbuf_decl.h"
+ *
+ * The matching definitions are generated in one translation unit by
+ * including ringbuf_impl.h with the same parameters.
+ *
+ * Each instance is a single-producer/single-consumer ring with its storage
+ * inline, so it can be allocated statically, and its capacity is a
+ * compile-time constant, so indexing uses a constant mask. Producer
+ * functions must only be called from one task and consumer functions from
+ * one other task. The producer never touches the read index: when the ring
+ * is full, new elements are dropped and counted in _overruns(), and it is up
+ * to the consumer to catch up with _skip_to_latest().
+ */
+#if !defined(RINGBUF_NAME) || !defined(RINGBUF_TYPE) || !defined(RINGBUF_CAPACITY)
+#error "RINGBUF_NAME, RINGBUF_TYPE and RINGBUF_CAPACITY must be defined"
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifndef RINGBUF_FN
+#define RINGBUF_CAT_(a, b)      a##_##b
+#define RINGBUF_CAT(a, b)       RINGBUF_CAT_(a, b)
+#define RINGBUF_FN(fn)          RINGBUF_CAT(RINGBUF_NAME, fn)
+#endif
+
+// Padding between the producer and consumer indices
+#ifndef RINGBUF_CACHE_LINE
+#define RINGBUF_CACHE_LINE      64
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+_Static_assert(RINGBUF_CAPACITY > 0 && (RINGBUF_CAPACITY & (RINGBUF_CAPACITY - 1)) == 0,
+               "ring buffer capacity must be a power of two");
+
+typedef struct RINGBUF_FN(t)
+{
+    // Producer
+    atomic_uint write;
+    atomic_uint overruns;
+    uint8_t pad0[RINGBUF_CACHE_LINE];
+
+    // Consumer
+    atomic_uint read;
+    uint8_t pad1[RINGBUF_CACHE_LINE];
+
+    RINGBUF_TYPE buffer[RINGBUF_CAPACITY];
+} RINGBUF_FN(t);
+
+typedef RINGBUF_FN(t)* RINGBUF_FN(handle_t);
+
+// Also initialises a statically allocated ring. Not thread safe, both sides
+// must be idle.
+void RINGBUF_FN(reset)(RINGBUF_FN(handle_t) rbuf);
+
+// Producer
+
+// Returns false if the ring is full and the element was dropped
+bool RINGBUF_FN(write)(RINGBUF_FN(handle_t) rbuf, RINGBUF_TYPE val);
+
+// Writes as many elements as fit, returns the number written
+size_t RINGBUF_FN(write_buf)(RINGBUF_FN(handle_t) rbuf, const RINGBUF_TYPE* buf, size_t size);
+
+// Zero-copy access. reserve/peek return a contiguous region of at most size
+// elements and store its length in len, which is shorter than requested at
+// the wrap point. commit/consume publish elements written to/read from it.
+RINGBUF_TYPE* RINGBUF_FN(reserve)(RINGBUF_FN(handle_t) rbuf, size_t size, size_t* len);
+
+void RINGBUF_FN(commit)(RINGBUF_FN(handle_t) rbuf, size_t size);
+
+// Consumer
+
+RINGBUF_TYPE RINGBUF_FN(read)(RINGBUF_FN(handle_t) rbuf);
+
+// Reads up to size elements, returns the number actually read
+size_t RINGBUF_FN(read_buf)(RINGBUF_FN(handle_t) rbuf, RINGBUF_TYPE* buf, size_t size);
+
+const RINGBUF_TYPE* RINGBUF_FN(peek)(RINGBUF_FN(handle_t) rbuf, size_t size, size_t* len);
+
+void RINGBUF_FN(consume)(RINGBUF_FN(handle_t) rbuf, size_t size);
+
+// Discards all but the newest keep elements, returns the number discarded
+size_t RINGBUF_FN(skip_to_latest)(RINGBUF_FN(handle_t) rbuf, size_t keep);
+
+// Either side
+
+// Total elements dropped by the producer since the last reset
+uint32_t RINGBUF_FN(overruns)(RINGBUF_FN(handle_t) rbuf);
+
+bool RINGBUF_FN(empty)(RINGBUF_FN(handle_t) rbuf);
+
+bool RINGBUF_FN(full)(RINGBUF_FN(handle_t) rbuf);
+
+size_t RINGBUF_FN(size)(RINGBUF_FN(handle_t) rbuf);
+
+size_t RINGBUF_FN(avail)(RINGBUF_FN(handle_t) rbuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#undef RINGBUF_NAME
+#undef RINGBUF_TYPE
+#undef RINGBUF_CAPACITY
@@ -0,0 +1,206 @@
+/*
+ * Generates the definitions for one member of the ring buffer family, see
+ * ringbuf_decl.h. Include from exactly one translation unit per instance,
+ * after the instance header and with the same parameters.
+ *
+ * Single-producer/single-consumer contract: write and overruns are only
+ * stored by the producer, read only by the consumer. Each side loads the
+ * other's index with acquire and publishes its own with release, so the
+ * element stores/loads are ordered against the index that hands them over.
+ */
+#if !defined(RINGBUF_NAME) || !defined(RINGBUF_TYPE) || !defined(RINGBUF_CAPACITY)
+#error "RINGBUF_NAME, RINGBUF_TYPE and RINGBUF_CAPACITY must be defined"
+#endif
+
+#include <assert.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define RINGBUF_MASK(val)       ((val) & (RINGBUF_CAPACITY - 1))
+
+void RINGBUF_FN(reset)(RINGBUF_FN(handle_t) rbuf)
+{
+    assert(rbuf);
+
+    atomic_init(&rbuf->read, 0);
+    atomic_init(&rbuf->write, 0);
+    atomic_init(&rbuf->overruns, 0);
+}
+
+//--------------------------------------------------------------------+
+// Producer
+//--------------------------------------------------------------------+
+
+static void RINGBUF_FN(overrun)(RINGBUF_FN(handle_t) rbuf, size_t dropped)
+{
+    uint32_t overruns = atomic_load_explicit(&rbuf->overruns, memory_order_relaxed);
+    atomic_store_explicit(&rbuf->overruns, overruns + dropped, memory_order_relaxed);
+}
+
+bool RINGBUF_FN(write)(RINGBUF_FN(handle_t) rbuf, RINGBUF_TYPE val)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    if (write - read == RINGBUF_CAPACITY) {
+        RINGBUF_FN(overrun)(rbuf, 1);
+        return false;
+    }
+
+    rbuf->buffer[RINGBUF_MASK(write)] = val;
+    atomic_store_explicit(&rbuf->write, write + 1, memory_order_release);
+
+    return true;
+}
+
+size_t RINGBUF_FN(write_buf)(RINGBUF_FN(handle_t) rbuf, const RINGBUF_TYPE *buf, size_t size)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    size_t avail = RINGBUF_CAPACITY - (write - read);
+    if (size > avail) {
+        RINGBUF_FN(overrun)(rbuf, size - avail);
+        size = avail;
+    }
+
+    // At most two spans: up to the end of the buffer, then from the start
+    uint32_t start = RINGBUF_MASK(write);
+    size_t first = RINGBUF_CAPACITY - start;
+    if (first > size)
+        first = size;
+    memcpy(&rbuf->buffer[start], buf, first * sizeof(RINGBUF_TYPE));
+    memcpy(rbuf->buffer, buf + first, (size - first) * sizeof(RINGBUF_TYPE));
+
+    atomic_store_explicit(&rbuf->write, write + size, memory_order_release);
+
+    return size;
+}
+
+RINGBUF_TYPE *RINGBUF_FN(reserve)(RINGBUF_FN(handle_t) rbuf, size_t size, size_t *len)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    uint32_t start = RINGBUF_MASK(write);
+    size_t avail = RINGBUF_CAPACITY - (write - read);
+    if (size > avail)
+        size = avail;
+    if (size > RINGBUF_CAPACITY - start)
+        size = RINGBUF_CAPACITY - start;
+
+    *len = size;
+    return &rbuf->buffer[start];
+}
+
+void RINGBUF_FN(commit)(RINGBUF_FN(handle_t) rbuf, size_t size)
+{
+    assert(size <= RINGBUF_FN(avail)(rbuf));
+
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    atomic_store_explicit(&rbuf->write, write + size, memory_order_release);
+}
+
+//--------------------------------------------------------------------+
+// Consumer
+//--------------------------------------------------------------------+
+
+RINGBUF_TYPE RINGBUF_FN(read)(RINGBUF_FN(handle_t) rbuf)
+{
+    assert(!RINGBUF_FN(empty)(rbuf));
+
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    RINGBUF_TYPE val = rbuf->buffer[RINGBUF_MASK(read)];
+    atomic_store_explicit(&rbuf->read, read + 1, memory_order_release);
+
+    return val;
+}
+
+size_t RINGBUF_FN(read_buf)(RINGBUF_FN(handle_t) rbuf, RINGBUF_TYPE *buf, size_t size)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+    if (size > count)
+        size = count;
+
+    uint32_t start = RINGBUF_MASK(read);
+    size_t first = RINGBUF_CAPACITY - start;
+    if (first > size)
+        first = size;
+    memcpy(buf, &rbuf->buffer[start], first * sizeof(RINGBUF_TYPE));
+    memcpy(buf + first, rbuf->buffer, (size - first) * sizeof(RINGBUF_TYPE));
+
+    atomic_store_explicit(&rbuf->read, read + size, memory_order_release);
+
+    return size;
+}
+
+const RINGBUF_TYPE *RINGBUF_FN(peek)(RINGBUF_FN(handle_t) rbuf, size_t size, size_t *len)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    uint32_t start = RINGBUF_MASK(read);
+    size_t count = write - read;
+    if (size > count)
+        size = count;
+    if (size > RINGBUF_CAPACITY - start)
+        size = RINGBUF_CAPACITY - start;
+
+    *len = size;
+    return &rbuf->buffer[start];
+}
+
+void RINGBUF_FN(consume)(RINGBUF_FN(handle_t) rbuf, size_t size)
+{
+    assert(size <= RINGBUF_FN(size)(rbuf));
+
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    atomic_store_explicit(&rbuf->read, read + size, memory_order_release);
+}
+
+size_t RINGBUF_FN(skip_to_latest)(RINGBUF_FN(handle_t) rbuf, size_t keep)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+    if (count <= keep)
+        return 0;
+
+    atomic_store_explicit(&rbuf->read, write - keep, memory_order_release);
+
+    return count - keep;
+}
+
+//--------------------------------------------------------------------+
+// Either side
+//--------------------------------------------------------------------+
+
+uint32_t RINGBUF_FN(overruns)(RINGBUF_FN(handle_t) rbuf)
+{
+    return atomic_load_explicit(&rbuf->overruns, memory_order_relaxed);
+}
+
+bool RINGBUF_FN(empty)(RINGBUF_FN(handle_t) rbuf)
+{
+    return RINGBUF_FN(size)(rbuf) == 0;
+}
+
+bool RINGBUF_FN(full)(RINGBUF_FN(handle_t) rbuf)
+{
+    return RINGBUF_FN(size)(rbuf) == RINGBUF_CAPACITY;
+}
+
+size_t RINGBUF_FN(size)(RINGBUF_FN(handle_t) rbuf)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    return write - read;
+}
+
+size_t RINGBUF_FN(avail)(RINGBUF_FN(handle_t) rbuf)
+{
+    return (RINGBUF_CAPACITY - RINGBUF_FN(size)(rbuf));
+}
+
+#undef RINGBUF_MASK
+#undef RINGBUF_NAME
+#undef RINGBUF_TYPE
+#undef RINGBUF_CAPACITY
@@ -0,0 +1,16 @@
+#include "ringbuf_samples.h"
+
+#define RINGBUF_NAME            ringbuf_i16x2
+#define RINGBUF_TYPE            sample_i16x2_t
+#define RINGBUF_CAPACITY        RINGBUF_I16X2_CAPACITY
+#include "ringbuf_impl.h"
+
+#define RINGBUF_NAME            ringbuf_i32
+#define RINGBUF_TYPE            int32_t
+#define RINGBUF_CAPACITY        RINGBUF_I32_CAPACITY
+#include "ringbuf_impl.h"
+
+#define RINGBUF_NAME            ringbuf_f32
+#define RINGBUF_TYPE            float
+#define RINGBUF_CAPACITY        RINGBUF_F32_CAPACITY
+#include "ringbuf_impl.h"
@@ -0,0 +1,38 @@
+#ifndef __RINGBUF_SAMPLES_H__
+#define __RINGBUF_SAMPLES_H__
+
+#include <stdint.h>
+
+// Ring buffer instances for the non-mono-16-bit sample formats, see
+// ringbuf_i16.h for the mono one.
+
+typedef struct {
+    int16_t l;
+    int16_t r;
+} sample_i16x2_t;
+
+// Stereo 16-bit frames
+#define RINGBUF_I16X2_CAPACITY  512
+
+#define RINGBUF_NAME            ringbuf_i16x2
+#define RINGBUF_TYPE            sample_i16x2_t
+#define RINGBUF_CAPACITY        RINGBUF_I16X2_CAPACITY
+#include "ringbuf_decl.h"
+
+// 32-bit samples, also carrying 24-bit audio left justified
+#define RINGBUF_I32_CAPACITY    1024
+
+#define RINGBUF_NAME            ringbuf_i32
+#define RINGBUF_TYPE            int32_t
+#define RINGBUF_CAPACITY        RINGBUF_I32_CAPACITY
+#include "ringbuf_decl.h"
+
+// Float samples
+#define RINGBUF_F32_CAPACITY    1024
+
+#define RINGBUF_NAME            ringbuf_f32
+#define RINGBUF_TYPE            float
+#define RINGBUF_CAPACITY        RINGBUF_F32_CAPACITY
+#include "ringbuf_decl.h"
+
+#endif // __RINGBUF_SAMPLES_H__
@@ -1,8 +1,15 @@
 #include "usb_audio_cb.h"
 #include "tinyusb.h"
 #include "esp_log.h"
-#include "freertos/ringbuf.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "war_espnow.h"
+#include "plc.h"
+#include "asrc.h"
+#include "usb_pacer.h"
+#include "resample.h"
+#include "gain.h"
+#include "war_config.h"
 
 static const char *TAG = "USB Audio";
 
@@ -55,19 +62,74 @@ int16_t  sine_buffer[SINE_SAMPLES];
 uint16_t sine_index = 0;
 uint16_t test_buffer_audio[CFG_TUD_AUDIO_FUNC_1_EP_SZ_IN / 2];
 uint16_t startVal = 0;
-RingbufHandle_t rbuf = NULL;
+ringbuf_bcast_t* rbuf = NULL;
+int rbuf_reader = -1;
 
-const size_t audio_ringbuffer_len = 48 * 15 * sizeof(int16_t);
+static plc_t plc;
+static usb_pacer_t pacer;
+#if !USB_AUDIO_ASYNC
+static asrc_t asrc;
+#endif
+static resample_t resample;
+static gain_t gain;
+
+// Rate of the network stream, set from the ESP-NOW task
+static volatile uint32_t stream_sample_rate = SAMPLERATE;
+
+// Ring fill the pacer or resampler steers to, also the cushion refilled
+// after an underrun
+#define USB_AUDIO_FILL_FRAMES   (48 * 8)
+
+// The IN endpoint must take the largest USB frame the pacer sends
+TU_VERIFY_STATIC(CFG_TUD_AUDIO_FUNC_1_EP_SZ_IN >= USB_PACER_MAX_FRAMES * AUDIO_CHANNELS * sizeof(audio_sample_t),
+                 "IN endpoint too small for the pacer");
 
 tu_fifo_t* ep_in_fifo = NULL;
 
-void init_usb_audio_ringbuffer() {
-    rbuf = xRingbufferCreate(audio_ringbuffer_len, RINGBUF_TYPE_BYTEBUF);
-    if (rbuf == NULL) {
-        ESP_LOGE(TAG, "Failed to create ringbuffer");
+void init_usb_audio_ringbuffer(ringbuf_bcast_t* audio_rbuf) {
+    plc_init(&plc);
+    gain_init(&gain);
+    usb_pacer_init(&pacer, current_sample_rate, USB_AUDIO_FILL_FRAMES);
+#if !USB_AUDIO_ASYNC
+    asrc_init(&asrc, USB_AUDIO_FILL_FRAMES);
+#endif
+    // Build every ratio's table now, switching rates in the audio callback
+    // then only resets the resampler
+    for (int i = 0; i < N_SAMPLE_RATES; i++) {
+        for (int j = 0; j < N_SAMPLE_RATES; j++) {
+            if (i != j && !resample_prepare(sample_rates[i], sample_rates[j])) {
+                ESP_LOGE(TAG, "No resampler from %u Hz to %u Hz", sample_rates[i], sample_rates[j]);
+            }
+        }
+    }
+    resample_init(&resample, stream_sample_rate, current_sample_rate);
+    rbuf_reader = ringbuf_bcast_add_reader(audio_rbuf);
+    if (rbuf_reader < 0) {
+        ESP_LOGE(TAG, "Failed to add ringbuffer reader");
         return;
     }
-    espnow_set_rbuf(rbuf, audio_ringbuffer_len);
+    rbuf = audio_rbuf;
+}
+
+void usb_audio_set_format(const espnow_stream_format_t* format) {
+    // The audio callback picks the resampler up from here
+    stream_sample_rate = format->sample_rate;
+    if (format->sample_rate != current_sample_rate) {
+        ESP_LOGI(TAG, "Resampling %u Hz stream to %u Hz", format->sample_rate, current_sample_rate);
+    }
+}
+
+// Follows the stream and host rates, from the audio callback
+static void usb_audio_rates_update()
+{
+    uint32_t in_rate = stream_sample_rate;
+    if (in_rate == resample.in_rate && current_sample_rate == resample.out_rate) {
+        return;
+    }
+    // Tables are built at init, an unsupported pair passes through at the
+    // wrong speed
+    resample_init(&resample, in_rate, current_sample_rate);
+    usb_pacer_init(&pacer, current_sample_rate, USB_AUDIO_FILL_FRAMES);
 }
 
 //--------------------------------------------------------------------+
@@ -137,13 +199,25 @@ bool tud_audio_set_itf_cb(uint8_t rhport, tusb_control_request_t const *p_reques
     uint8_t const alt = tu_u16_low(tu_le16toh(p_request->wValue));
 
     ESP_LOGI(TAG, "Set interface %d alt %d\r\n", itf, alt);
-    if (itf == 1 && alt == 1) {
-        espnow_set_rbuf_state(ESPNOW_RBUF_ACTIVE);
+    if (itf == 1 && alt == 1 && rbuf) {
+        ringbuf_bcast_set_active(rbuf, rbuf_reader, true);
     }
 
     return true;
 }
 
+// Host volume and mute as a gain per channel, master times channel
+static void usb_audio_gain_update()
+{
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+        int32_t g = 0;
+        if (!mute[0] && !mute[ch + 1]) {
+            g = (gain_from_db(volume[0]) * gain_from_db(volume[ch + 1]) + (1 << 14)) >> 15;
+        }
+        gain_set(&gain, ch, g);
+    }
+}
+
 // Helper for feature unit set requests
 static bool tud_audio_feature_unit_set_request(uint8_t rhport, audio_control_request_t const *request, uint8_t const *buf)
 {
@@ -151,12 +225,14 @@ static bool tud_audio_feature_unit_set_request(uint8_t rhport, audio_control_req
 
     TU_ASSERT(request->bEntityID == 0x02);
     TU_VERIFY(request->bRequest == AUDIO_CS_REQ_CUR);
+    TU_VERIFY(request->bChannelNumber <= CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX);
 
     if (request->bControlSelector == AUDIO_FU_CTRL_MUTE)
     {
         TU_VERIFY(request->wLength == sizeof(audio_control_cur_1_t));
 
         mute[request->bChannelNumber] = ((audio_control_cur_1_t *)buf)->bCur;
+        usb_audio_gain_update();
 
         ESP_LOGV(TAG, "Set channel %d Mute: %d\r\n", request->bChannelNumber, mute[request->bChannelNumber]);
 
@@ -167,6 +243,7 @@ static bool tud_audio_feature_unit_set_request(uint8_t rhport, audio_control_req
         TU_VERIFY(request->wLength == sizeof(audio_control_cur_2_t));
 
         volume[request->bChannelNumber] = ((audio_control_cur_2_t const *)buf)->bCur;
+        usb_audio_gain_update();
 
         ESP_LOGV(TAG, "Set channel %d volume: %d dB\r\n", request->bChannelNumber, volume[request->bChannelNumber] / 256);
 
@@ -180,6 +257,37 @@ static bool tud_audio_feature_unit_set_request(uint8_t rhport, audio_control_req
     }
 }
 
+// Helper for clock set requests
+static bool tud_audio_clock_set_request(uint8_t rhport, audio_control_request_t const *request, uint8_t const *buf)
+{
+    (void)rhport;
+
+    TU_ASSERT(request->bEntityID == 0x04);
+    TU_VERIFY(request->bRequest == AUDIO_CS_REQ_CUR);
+
+    if (request->bControlSelector == AUDIO_CS_CTRL_SAM_FREQ)
+    {
+        TU_VERIFY(request->wLength == sizeof(audio_control_cur_4_t));
+
+        uint32_t rate = tu_le32toh(((audio_control_cur_4_t const *)buf)->bCur);
+        for (uint8_t i = 0; i < N_SAMPLE_RATES; i++)
+        {
+            if (sample_rates[i] == rate)
+            {
+                // The next audio callback switches the resampler and pacer over
+                current_sample_rate = rate;
+                ESP_LOGI(TAG, "Clock set freq %u\r\n", rate);
+                return true;
+            }
+        }
+        ESP_LOGW(TAG, "Clock set freq %u not supported\r\n", rate);
+        return false;
+    }
+    ESP_LOGV(TAG, "Clock set request not supported, entity = %u, selector = %u, request = %u\r\n",
+             request->bEntityID, request->bControlSelector, request->bRequest);
+    return false;
+}
+
 // Invoked when audio class specific set request received for an entity
 bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const *p_request, uint8_t *pBuff)
 {
@@ -190,6 +298,10 @@ bool tud_audio_set_req_entity_cb(uint8_t rhport, tusb_control_request_t const *p
     if (request->bEntityID == 0x02)
         return tud_audio_feature_unit_set_request(rhport, request, pBuff);
 
+    // If request is for our clock source
+    if (request->bEntityID == 0x04)
+        return tud_audio_clock_set_request(rhport, request, pBuff);
+
     ESP_LOGV(TAG, "Set request not handled, entity = %d, selector = %d, request = %d\r\n",
              request->bEntityID, request->bControlSelector, request->bRequest);
 
@@ -284,6 +396,7 @@ static bool tud_audio_clock_get_request(uint8_t rhport, audio_control_request_t
 static bool tud_audio_feature_unit_get_request(uint8_t rhport, audio_control_request_t const *request)
 {
     TU_ASSERT(request->bEntityID == 0x02);
+    TU_VERIFY(request->bChannelNumber <= CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX);
     ESP_LOGV(TAG, "Audio Get Feature Unit");
 
     if (request->bControlSelector == AUDIO_FU_CTRL_MUTE && request->bRequest == AUDIO_CS_REQ_CUR)
@@ -339,7 +452,8 @@ bool tud_audio_get_req_entity_cb(uint8_t rhport, tusb_control_request_t const *p
             audio_desc_channel_cluster_t ret;
 
             // Those are dummy values for now
-            ret.bNrChannels = 1;
+            ret.bNrChannels = CFG_TUD_AUDIO_FUNC_1_N_CHANNELS_TX;
+
             ret.bmChannelConfig = 0;
             ret.iChannelNames = 0;
 
@@ -380,19 +494,14 @@ bool tud_audio_set_itf_close_EP_cb(uint8_t rhport, tusb_control_request_t const
 
     ESP_LOGV(TAG, "Audio Set ITF Close EP: %u, %u\n", itf, alt);
 
-    espnow_set_rbuf_state(ESPNOW_RBUF_INACTIVE);
     if (rbuf) {
-        size_t bytes_recv;
-        void* data = xRingbufferReceiveUpTo(rbuf, &bytes_recv, 0, audio_ringbuffer_len);
-        if (data) {
-            vRingbufferReturnItem(rbuf, data);
-        }
+        ringbuf_bcast_set_active(rbuf, rbuf_reader, false);
     }
 
     return true;
 }
 
-bool tud_audio_tx_done_pre_load_cb(uint8_t rhport, uint8_t itf, uint8_t ep_in, uint8_t cur_alt_setting)
+AUDIO_HOT bool tud_audio_tx_done_pre_load_cb(uint8_t rhport, uint8_t itf, uint8_t ep_in, uint8_t cur_alt_setting)
 {
     //ESP_LOGI(TAG, "Audio TX Done Preload");
     (void)rhport;
@@ -401,46 +510,75 @@ bool tud_audio_tx_done_pre_load_cb(uint8_t rhport, uint8_t itf, uint8_t ep_in, u
     (void)cur_alt_setting;
 
     static bool filling = false;
-    static bool fade_in_next = false;
-    static int16_t last_ms[48];
-    static int16_t fade_ms[48];
-    static int16_t last_len;
+    static audio_sample_t in[RESAMPLE_MAX_IN * AUDIO_CHANNELS];
+#if !USB_AUDIO_ASYNC
+    static audio_sample_t mid[RESAMPLE_MAX_IN * AUDIO_CHANNELS];
+#endif
+    static audio_sample_t data[USB_PACER_MAX_FRAMES * AUDIO_CHANNELS];
+
+    if (rbuf == NULL) {
+        return true;
+    }
 
+    int64_t start = esp_timer_get_time();
+    uint32_t start_cycles = esp_cpu_get_ccount();
+    usb_audio_rates_update();
+    // Frames at the host's rate, 48 or 44 and 45 at 44.1 kHz. In
+    // asynchronous mode the transmitter's clock sets the pace and the host
+    // follows, so the odd frame more or less goes out.
+    size_t frames = usb_pacer_frames(&pacer);
+    // Frames at the stream's rate covering them
+    size_t stream_frames = resample_active(&resample) ? resample_input_frames(&resample, frames) : frames;
+#if USB_AUDIO_ASYNC
+    size_t want = stream_frames;
+#else
+    // The host clock sets the pace, the drift resampler takes whatever the
+    // transmitter's clock needs to cover it
+    size_t want = asrc_input_frames(&asrc, stream_frames);
+#endif
     if (!filling) {
-        size_t bytes_recv;
-        uint8_t* data = xRingbufferReceiveUpTo(rbuf, &bytes_recv, 0, 48 * sizeof(int16_t));
-        if (data != NULL) {
-            if (fade_in_next) {
-                fade_in_next = false;
-                int16_t* word = (int16_t*) data;
-                float mod = 0.025f;
-                for (int i = 0; i < bytes_recv / sizeof(int16_t); i++) {
-                    word[i] *= mod;
-                    mod = TU_MIN(mod + 0.025f, 1.f);
-                }
-            }
-            tud_audio_write(data, bytes_recv);
-            memcpy(last_ms, data, bytes_recv);
-            last_len = bytes_recv / sizeof(int16_t);
-            vRingbufferReturnItem(rbuf, data);
+        // The whole packet or nothing, what is left waits for the refill
+        if (ringbuf_bcast_read_frames(rbuf, rbuf_reader, in, want)) {
+            plc_good_frame(&plc, in, want);
+#if USB_AUDIO_ASYNC
+            usb_pacer_steer(&pacer, ringbuf_bcast_size(rbuf, rbuf_reader) / AUDIO_CHANNELS, want);
+#else
+            asrc_steer(&asrc, ringbuf_bcast_size(rbuf, rbuf_reader) / AUDIO_CHANNELS, stream_frames);
+#endif
         } else {
             debug.missed_audio_cb++;
             filling = true;
-            float mod = 1.f;
-            for (int i = 0; i < 48; i++) {
-                fade_ms[i] = last_ms[last_len - 1] * mod;
-                mod -= 0.025f;
-                mod = TU_MAX(mod, 0.f);
-            }
-            tud_audio_write(fade_ms, sizeof(fade_ms));
+            plc_conceal(&plc, in, want);
         }
     } else {
-        const size_t threshold = 48 * sizeof(int16_t) * 8;
-        size_t current = audio_ringbuffer_len - xRingbufferGetCurFreeSize(rbuf);
-        if (current >= threshold) {
+        // Keep concealing until the cushion has refilled
+        if (ringbuf_bcast_size(rbuf, rbuf_reader) >= USB_AUDIO_FILL_FRAMES * AUDIO_CHANNELS) {
             filling = false;
-            fade_in_next = true;
         }
+        plc_conceal(&plc, in, want);
+    }
+    audio_sample_t *out = in;
+#if USB_AUDIO_ASYNC
+    debug.usb_drift_ppm = usb_pacer_ppm(&pacer);
+#else
+    asrc_process(&asrc, in, mid, stream_frames);
+    out = mid;
+    debug.usb_drift_ppm = asrc_ppm(&asrc);
+#endif
+    if (resample_active(&resample)) {
+        resample_process(&resample, out, data, frames);
+        out = data;
+    }
+    gain_apply(&gain, out, frames);
+    tud_audio_write(out, frames * AUDIO_CHANNELS * sizeof(audio_sample_t));
+
+    uint32_t cycles = esp_cpu_get_ccount() - start_cycles;
+    uint32_t elapsed = esp_timer_get_time() - start;
+    if (elapsed > debug.usb_cb_us_max) {
+        debug.usb_cb_us_max = elapsed;
+    }
+    if (cycles > debug.usb_cb_cycles_max) {
+        debug.usb_cb_cycles_max = cycles;
     }
 
     return true;
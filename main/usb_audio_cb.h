@@ -1,6 +1,8 @@
 #ifndef __USB_AUDIO_CB_H__
 #define __USB_AUDIO_CB_H__
 #include <stdint.h>
+#include "ringbuf_bcast.h"
+#include "war_espnow.h"
 
 extern const uint32_t sample_rates[];
 extern uint32_t current_sample_rate;
@@ -8,6 +10,7 @@ extern uint32_t current_sample_rate;
 #define SINE_SAMPLES    109
 extern int16_t sine_buffer[];
 
-void init_usb_audio_ringbuffer();
+void init_usb_audio_ringbuffer(ringbuf_bcast_t* audio_rbuf);
+void usb_audio_set_format(const espnow_stream_format_t* format);
 
 #endif // __USB_AUDIO_CB_H__
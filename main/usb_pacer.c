@@ -0,0 +1,60 @@
+#include "usb_pacer.h"
+#include "audio_format.h"
+
+#define USB_PACER_Q32_PER_PPM   4295            // 2^32 / 10^6
+#define USB_FRAMES_PER_SEC      1000            // Full speed SOF rate
+
+// Fill controller, the same loop as the resampler's: critically damped
+// with a time constant of about 4 s at 48 kHz
+#define USB_PACER_KP            168             // Q32 delta per Q8 frame of error, 10 ppm per frame
+#define USB_PACER_KI            27              // Q48 delta per Q8 frame of error per frame
+#define USB_PACER_AVG_SHIFT     7               // Error averaged over 128 USB frames
+
+void usb_pacer_init(usb_pacer_t *pacer, uint32_t sample_rate, size_t target_fill)
+{
+    pacer->step = ((uint64_t)sample_rate << 32) / USB_FRAMES_PER_SEC;
+    // Start half way so the nominal rate rounds evenly from the first frame
+    pacer->acc = 1ull << 31;
+    pacer->delta = 0;
+    pacer->target = target_fill;
+    pacer->error_avg = 0;
+    pacer->integral = 0;
+}
+
+AUDIO_HOT size_t usb_pacer_frames(usb_pacer_t *pacer)
+{
+    // step is below 2^38 and delta below 2^22, the product fits
+    pacer->acc += pacer->step + ((int64_t)pacer->step * pacer->delta >> 32);
+    size_t frames = pacer->acc >> 32;
+    if (frames > USB_PACER_MAX_FRAMES) {
+        frames = USB_PACER_MAX_FRAMES;
+    }
+    pacer->acc -= (uint64_t)frames << 32;
+    return frames;
+}
+
+AUDIO_HOT void usb_pacer_steer(usb_pacer_t *pacer, size_t fill, size_t frames)
+{
+    const int64_t limit = (int64_t)USB_PACER_MAX_PPM * USB_PACER_Q32_PER_PPM;
+    int32_t error = ((int32_t)fill - pacer->target) * 256;
+    pacer->error_avg += (error - pacer->error_avg) / (1 << USB_PACER_AVG_SHIFT);
+
+    // A full ring means the transmitter is fast, so send faster
+    pacer->integral += (int64_t)pacer->error_avg * USB_PACER_KI * (int64_t)frames;
+    if (pacer->integral > limit << 16)
+        pacer->integral = limit << 16;
+    if (pacer->integral < -(limit << 16))
+        pacer->integral = -(limit << 16);
+
+    int64_t delta = (int64_t)pacer->error_avg * USB_PACER_KP + (pacer->integral >> 16);
+    if (delta > limit)
+        delta = limit;
+    if (delta < -limit)
+        delta = -limit;
+    pacer->delta = delta;
+}
+
+int32_t usb_pacer_ppm(const usb_pacer_t *pacer)
+{
+    return (int64_t)pacer->delta * 1000000 >> 32;
+}
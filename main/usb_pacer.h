@@ -0,0 +1,57 @@
+#ifndef __USB_PACER_H__
+#define __USB_PACER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define USB_PACER_MAX_PPM       1000            // Correction the fill controller may apply
+#define USB_PACER_MAX_FRAMES    49              // Per USB frame, the IN endpoint is sized for one over 48 kHz
+
+/*
+ * Paces the asynchronous USB IN endpoint: the device, not the host, owns
+ * the sample clock, so each 1 ms USB frame carries however many frames the
+ * transmitter's clock produced in it. A Q32 accumulator adds the frames per
+ * USB frame every call and sends the whole part, which at 48 kHz is 48 with
+ * the odd 47 or 49 as the accumulator wraps. The host measures the data
+ * rate and follows it.
+ *
+ * The rate is the nominal one times 1 + delta, delta in Q32, steered by a
+ * PI controller on the averaged fill of the network ring the same way
+ * asrc_steer is: a filling ring means the transmitter runs fast, so more
+ * frames go out. The samples themselves pass untouched.
+ *
+ * Call usb_pacer_frames once per USB frame, send that many frames, then
+ * usb_pacer_steer. Not thread safe.
+ */
+typedef struct {
+    uint64_t step;                              // Q32 nominal frames per USB frame
+    uint64_t acc;                               // Q32 fraction carried to the next USB frame
+    int32_t delta;                              // Q32 ratio - 1
+
+    // Fill controller
+    int32_t target;                             // Frames
+    int32_t error_avg;                          // Frames, Q8
+    int64_t integral;                           // Q32
+} usb_pacer_t;
+
+void usb_pacer_init(usb_pacer_t* pacer, uint32_t sample_rate, size_t target_fill);
+
+// Frames to send in the next USB frame
+size_t usb_pacer_frames(usb_pacer_t* pacer);
+
+// Adjusts the rate from the fill of the ring, in frames, after sending
+// frames
+void usb_pacer_steer(usb_pacer_t* pacer, size_t fill, size_t frames);
+
+// Current correction, parts per million
+int32_t usb_pacer_ppm(const usb_pacer_t* pacer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __USB_PACER_H__
@@ -2,8 +2,86 @@
 #define __WAR_CONFIG_H__
 
 #include <stdint.h>
+#include "sdkconfig.h"
 
-#define MS_PER_PACKET   2
-#define SAMPLERATE      48000
+// Packet duration the transmitter starts with, espnow_set_packet_ms()
+// changes it at runtime. Each packet carries its own duration, so the
+// receiver follows whatever the transmitter sends.
+#define MS_PER_PACKET       2
+#define MAX_MS_PER_PACKET   4
+#define SAMPLERATE          48000
+
+// Sample format delivered to the sinks and sent by the transmitter, set in
+// the "WAR Audio" menu since the USB descriptors are generated from it
+#ifdef CONFIG_AUDIO_CHANNELS
+#define AUDIO_CHANNELS          CONFIG_AUDIO_CHANNELS
+#else
+#define AUDIO_CHANNELS          1
+#endif
+#ifdef CONFIG_AUDIO_24BIT
+#define AUDIO_BYTES_PER_SAMPLE  4               // 24 bits left justified in 32
+#else
+#define AUDIO_BYTES_PER_SAMPLE  2
+#endif
+
+// Packets a sequence gap may hold back playout before the missing packet
+// is declared lost. Adds MS_PER_PACKET ms of latency per packet, but only
+// while waiting on a reordered packet.
+#define JITTER_BUFFER_DEPTH 3
+
+// Group size when the redundancy level is FEC: one XOR parity packet after
+// every ESPNOW_FEC_K audio packets. The receiver rebuilds any single packet
+// lost from a group, so the jitter buffer must be able to hold back a whole
+// group. 0 leaves FEC out, the levels are then none or copies only.
+#define ESPNOW_FEC_K        3
+
+// Redundancy the transmitter starts with, see redundancy.h. With
+// ESPNOW_ADAPTIVE_REDUNDANCY it then follows the loss the receivers report
+// every ESPNOW_FEEDBACK_MS, otherwise it stays put.
+#define ESPNOW_REDUNDANCY           REDUNDANCY_COPY1
+#define ESPNOW_ADAPTIVE_REDUNDANCY  1
+#define ESPNOW_FEEDBACK_MS          250
+
+// Channel both sides start on. With ESPNOW_CHANNEL_SELECT the transmitter
+// scores its channel from the feedback, moves to a better one of
+// ESPNOW_CHANNEL_MASK once it degrades and the receivers follow, see
+// channel.h. The switch is announced ESPNOW_CHANNEL_LEAD packets ahead.
+#define ESPNOW_CHANNEL              8
+#define ESPNOW_CHANNEL_SELECT       1
+#define ESPNOW_CHANNEL_MASK         ((1 << 1) | (1 << 6) | (1 << 8) | (1 << 11))
+#define ESPNOW_CHANNEL_LEAD         16
+
+// PHY rate to start at, see rate_ctrl.h. With ESPNOW_RATE_ADAPT the
+// transmitter then moves to the rate with the least airtime that still
+// delivers to its receivers. Receivers send their feedback at ESPNOW_RATE.
+#define ESPNOW_RATE                 RATE_36M
+#define ESPNOW_RATE_ADAPT           1
+
+// Transmitters a receiver takes in and mixes at once, and receive events
+// queued between the Wi-Fi driver and the ESP-NOW task. Together with the
+// jitter depth they size the receive packet pool, see packet_pool.h.
+#define ESPNOW_MAX_SOURCES          4
+#define ESPNOW_QUEUE_SIZE           12
+
+#if ESPNOW_FEC_K > 0 && JITTER_BUFFER_DEPTH < ESPNOW_FEC_K
+#error "JITTER_BUFFER_DEPTH must be at least ESPNOW_FEC_K"
+#endif
+
+// Payload format on the wire: ESPNOW_CODEC_PCM, ESPNOW_CODEC_ADPCM for a
+// quarter of the bytes at roughly 35-40 dB SNR, or ESPNOW_CODEC_LOSSLESS for
+// bit-exact audio in typically half to two thirds of the bytes. The
+// receiver decodes whichever format each packet carries. The compressed
+// codecs carry mono 16-bit audio only.
+#define ESPNOW_CODEC        ESPNOW_CODEC_PCM
+
+// Run the USB microphone asynchronously: each 1 ms USB frame carries the
+// frames the transmitter's clock produced, 47 to 49 at 48 kHz, and the host
+// follows, see usb_pacer.h. 0 sends the nominal count every USB frame and
+// resamples to it instead, for hosts that mishandle asynchronous IN.
+#define USB_AUDIO_ASYNC     1
+
+// Also drive the I2S codec when the USB sink is enabled, for boards that
+// have both. Each sink reads the ESP-NOW stream independently.
+#define I2S_SINK_WITH_USB   0
 
 #endif // __WAR_CONFIG_H__
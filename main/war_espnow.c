@@ -1,25 +1,37 @@
 #include "war_espnow.h"
 #include "war_config.h"
+#include "packet_model.h"
+#include "redundancy.h"
+#include "channel.h"
+#include "rate_ctrl.h"
+#include "war_wifi.h"
 
 #include <string.h>
 
 #include "esp_crc.h"
 #include "esp_log.h"
+#include "esp_wifi.h"
 
 #define ESPNOW_LOGGING 0
 
 #define ESPNOW_PMK "8u3NU3cdMdnxmnUN"
 #define ESPNOW_LMK "ZbtUUgbhnfo6WyTQ"
-#define ESPNOW_CHANNEL 8
-#define ESPNOW_SEND_LEN (48 * MS_PER_PACKET * sizeof(int16_t))
+// PCM that does not fit is split over packets, see espnow_packet_parts()
+#define ESPNOW_BUFFER_LEN ESP_NOW_MAX_DATA_LEN
 #define ESPNOW_MAXDELAY 128
+// Keeps the group alignment arithmetic valid when FEC is left out
+#define ESPNOW_FEC_GROUP (ESPNOW_FEC_K ? ESPNOW_FEC_K : 1)
+// Receivers wait on packets at most this long, so channel following runs
+#define ESPNOW_TICK_MS 10
 
 static const char *TAG = "ESP-NOW";
 
+_Static_assert(ESPNOW_CODEC == ESPNOW_CODEC_PCM ||
+                   (AUDIO_CHANNELS == 1 && AUDIO_BYTES_PER_SAMPLE == 2),
+               "compressed codecs are mono 16-bit only");
+
 bool is_receiver = false;
-RingbufHandle_t espnow_rbuf = NULL;
-size_t espnow_rbuf_len = 0;
-uint8_t espnow_data_state = ESPNOW_RBUF_INACTIVE;
+ringbuf_bcast_t *espnow_rbuf = NULL;
 
 xQueueHandle espnow_queue;
 xQueueHandle espnow_data_queue;
@@ -33,28 +45,127 @@ uint32_t espnow_seq[ESPNOW_DATA_MAX] = {0, 0};
 
 espnow_send_param_t *send_param;
 
+static packet_pool_t recv_pool;
+static fec_encoder_t fec_enc;
+static adpcm_state_t adpcm_enc;
+static audio_sample_t
+    tx_pcm[MAX_MS_PER_PACKET * ESPNOW_FRAME_SAMPLES * AUDIO_CHANNELS];
+static volatile uint8_t tx_frames_next = MS_PER_PACKET;
+static size_t tx_staged;  // Frames in tx_pcm
+static size_t tx_sent;    // Frames of tx_pcm already sent
+static size_t tx_part;    // Frames per packet
+static uint64_t tx_timestamp;
+static uint64_t tx_group_timestamp;
+static redundancy_level_t tx_level = ESPNOW_REDUNDANCY;
+static volatile redundancy_level_t tx_level_next = ESPNOW_REDUNDANCY;
+static redundancy_ctrl_t redundancy;
+
+static uint8_t own_mac[ESP_NOW_ETH_ALEN];  // Feedback about other transmitters is ignored
+
+// Channel selection. The controller belongs to the TX task, the link
+// samples built from feedback reach it through tx_link.
+static channel_ctrl_t channel_ctrl;
+static xQueueHandle tx_link;
+static uint8_t tx_switch_channel;  // Channel being migrated to, 0 for none
+static uint32_t tx_switch_seq;     // First audio packet on it
+static uint32_t tx_link_sent;      // Send callbacks since the last report
+static uint32_t tx_link_failed;
+static volatile uint32_t tx_link_dropped;
+static volatile uint32_t tx_link_bytes;
+
+// PHY rate, driven from the feedback on this task
+static rate_ctrl_t rate_ctrl;
+static channel_follow_t channel_follow;
+
+// Transmit window: a slot belongs to the driver from esp_now_send until its
+// send callback, so the next packets can go out before the last is acked
+static uint8_t tx_slots[ESPNOW_TX_WINDOW][ESPNOW_BUFFER_LEN + FEC_PARITY_HEADER]
+    __attribute__((aligned(4)));
+static int64_t tx_sent_at[ESPNOW_TX_WINDOW];
+static xQueueHandle tx_free;       // Slot indices ready to be filled
+static xQueueHandle tx_in_flight;  // Slot indices in send order
+
+static espnow_source_t sources[ESPNOW_MAX_SOURCES];
+static mixer_t mixer;
+
+_Static_assert(ESPNOW_MAX_SOURCES <= MIXER_MAX_SOURCES, "more sources than the mixer takes");
+// Every source with a full jitter buffer and an FEC rebuild in hand while
+// espnow_queue is full must not run the receive pool dry
+_Static_assert(PACKET_POOL_SIZE >= sizeof(sources) / sizeof(sources[0]) * PACKET_POOL_SOURCE_SLOTS +
+                                       ESPNOW_QUEUE_SIZE,
+               "receive pool smaller than the sources and queue can hold");
+_Static_assert(PACKET_POOL_SOURCE_SLOTS >= JITTER_BUFFER_DEPTH + (ESPNOW_FEC_K > 0),
+               "receive pool does not cover the jitter depth and FEC rebuild");
+static audio_sample_t mix_out[MIXER_FRAME * AUDIO_CHANNELS];
+static uint32_t mix_rate;  // Sample rate of the first source, 0 for none
+static espnow_format_cb_t format_cb = NULL;
+static int16_t rx_pcm[ESPNOW_MAX_PACKET_SAMPLES];
+static audio_sample_t rx_audio[ESPNOW_MAX_PACKET_SAMPLES * AUDIO_CHANNELS];
+
 espnow_debug_t debug = {0};
 
+static void espnow_release_slot(void *frame, void *ctx) {
+  packet_pool_free((packet_pool_t *)ctx, (packet_slot_t *)frame);
+}
+
 esp_err_t espnow_init(bool receiver) {
   is_receiver = receiver;
 
+  if (espnow_packet_parts(MS_PER_PACKET, ESPNOW_CODEC) == 0) {
+    ESP_LOGE(TAG, "%d ms packets do not fit", MS_PER_PACKET);
+    return ESP_ERR_INVALID_ARG;
+  }
+
   espnow_queue = xQueueCreate(ESPNOW_QUEUE_SIZE, sizeof(espnow_event_t));
   if (espnow_queue == NULL) {
     ESP_LOGE(TAG, "Create mutex fail");
     return ESP_FAIL;
   }
 
-  espnow_data_queue = xQueueCreate(ESPNOW_DATA_QUEUE_SIZE, ESPNOW_SEND_LEN);
+  espnow_data_queue = xQueueCreate(ESPNOW_DATA_QUEUE_SIZE, ESPNOW_FRAME_LEN);
   if (espnow_data_queue == NULL) {
     ESP_LOGE(TAG, "Create mutex fail");
     return ESP_FAIL;
   }
 
+  tx_free = xQueueCreate(ESPNOW_TX_WINDOW, sizeof(uint8_t));
+  tx_in_flight = xQueueCreate(ESPNOW_TX_WINDOW, sizeof(uint8_t));
+  if (tx_free == NULL || tx_in_flight == NULL) {
+    ESP_LOGE(TAG, "Create mutex fail");
+    return ESP_FAIL;
+  }
+  for (uint8_t i = 0; i < ESPNOW_TX_WINDOW; i++) {
+    xQueueSend(tx_free, &i, 0);
+  }
+
+  tx_link = xQueueCreate(1, sizeof(channel_link_sample_t));
+  if (tx_link == NULL) {
+    ESP_LOGE(TAG, "Create mutex fail");
+    return ESP_FAIL;
+  }
+  int64_t now_ms = esp_timer_get_time() / 1000;
+  channel_ctrl_init(&channel_ctrl, ESPNOW_CHANNEL, ESPNOW_CHANNEL_MASK, now_ms);
+  channel_follow_init(&channel_follow, ESPNOW_CHANNEL, ESPNOW_CHANNEL_MASK,
+                      now_ms);
+  rate_ctrl_init(&rate_ctrl, ESPNOW_RATE, now_ms);
+
+  packet_pool_init(&recv_pool);
+  memset(sources, 0, sizeof(sources));
+  mixer_init(&mixer);
+
   ESP_ERROR_CHECK(esp_now_init());
   ESP_ERROR_CHECK(esp_now_register_send_cb(espnow_send_cb));
   ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_recv_cb));
 
   ESP_ERROR_CHECK(esp_now_set_pmk((uint8_t *)ESPNOW_PMK));
+  ESP_ERROR_CHECK(esp_wifi_get_mac(ESP_IF_WIFI_STA, own_mac));
+#if ESPNOW_CHANNEL_SELECT
+  // Feedback then reports the link's RSSI and noise floor, migration works
+  // without them
+  if (is_receiver && war_wifi_monitor_start() != ESP_OK) {
+    ESP_LOGW(TAG, "No RSSI for channel selection");
+  }
+#endif
 
   uint8_t *peer_mac =
       broadcast_mac;  // is_receiver ? transmitter_mac : receiver_mac;
@@ -66,7 +177,8 @@ esp_err_t espnow_init(bool receiver) {
     return ESP_FAIL;
   }
   memset(peer, 0, sizeof(esp_now_peer_info_t));
-  peer->channel = ESPNOW_CHANNEL;
+  // Channel 0 follows the radio, so migrations need no peer update
+  peer->channel = 0;
   peer->ifidx = ESP_IF_WIFI_STA;
   peer->encrypt = false;
   memcpy(peer->peer_addr, peer_mac, ESP_NOW_ETH_ALEN);
@@ -81,45 +193,58 @@ esp_err_t espnow_init(bool receiver) {
     return ESP_FAIL;
   }
   send_param->state = 0;
-  send_param->resend_scheduled = false;
-  send_param->len = ESPNOW_SEND_LEN + sizeof(espnow_data_t);
-  send_param->buffer = malloc(send_param->len);
-  if (send_param->buffer == NULL) {
+  send_param->copies_scheduled = 0;
+  send_param->parity_scheduled = false;
+  send_param->frames = MS_PER_PACKET;
+  send_param->len = ESPNOW_BUFFER_LEN;
+  send_param->buffer = malloc(ESPNOW_BUFFER_LEN);
+  send_param->parity_buffer = malloc(ESPNOW_BUFFER_LEN + FEC_PARITY_HEADER);
+  if (send_param->buffer == NULL || send_param->parity_buffer == NULL) {
+    free(send_param->buffer);
+    free(send_param->parity_buffer);
     free(send_param);
     vSemaphoreDelete(espnow_queue);
     esp_now_deinit();
     return ESP_FAIL;
   }
   memcpy(send_param->dest_mac, peer_mac, ESP_NOW_ETH_ALEN);
+  fec_encoder_init(&fec_enc);
+  redundancy_init(&redundancy, ESPNOW_REDUNDANCY, ESPNOW_FEC_K > 0);
+  tx_level = tx_level_next = redundancy.level;
+  adpcm_init(&adpcm_enc);
 
 #if ESPNOW_LOGGING
   debug.time = esp_timer_get_time();
   debug.interval = 10 * 1000000;
   debug.last_micro = debug.time;
+  espnow_print_packet_model();
 #endif
 
-  xTaskCreatePinnedToCore(espnow_task, "ESP-Now Task", 3 * 1024, NULL, 4, NULL,
+  // The mixer's accumulator lives on this task's stack
+  xTaskCreatePinnedToCore(espnow_task, "ESP-Now Task", 4 * 1024, NULL, 4, NULL,
                           1);
+  if (!is_receiver) {
+    xTaskCreatePinnedToCore(espnow_tx_task, "ESP-Now TX", 3 * 1024, NULL, 4,
+                            NULL, 1);
+  }
 
   return ESP_OK;
 }
 
 void espnow_deinit(espnow_send_param_t *send_param) {
   free(send_param->buffer);
+  free(send_param->parity_buffer);
   free(send_param);
   vSemaphoreDelete(espnow_queue);
   esp_now_deinit();
 }
 
-void espnow_set_rbuf(RingbufHandle_t rbuf, size_t len) {
-  espnow_rbuf = rbuf;
-  espnow_rbuf_len = len;
-}
+void espnow_set_rbuf(ringbuf_bcast_t *rbuf) { espnow_rbuf = rbuf; }
 
-void espnow_set_rbuf_state(uint8_t state) {
-  espnow_data_state = state;
-  ESP_LOGI(TAG, "Setting Ringbuffer %s",
-           espnow_data_state ? "Active" : "Inactive");
+void espnow_set_format_cb(espnow_format_cb_t cb) { format_cb = cb; }
+
+void espnow_set_source_gain(int source, int32_t gain) {
+  mixer_set_gain(&mixer, source, gain);
 }
 
 void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
@@ -133,31 +258,32 @@ void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
   evt.id = ESPNOW_SEND_CB;
   memcpy(send_cb->mac_addr, mac_addr, ESP_NOW_ETH_ALEN);
   send_cb->status = status;
+  send_cb->time = esp_timer_get_time();
   if (xQueueSend(espnow_queue, &evt, ESPNOW_MAXDELAY) != pdTRUE) {
     ESP_LOGW(TAG, "Send queue failed.");
   }
 }
 
-void espnow_recv_cb(const uint8_t *mac_addr, const uint8_t *data, int len) {
+AUDIO_HOT void espnow_recv_cb(const uint8_t *mac_addr, const uint8_t *data, int len) {
   espnow_event_t evt;
   espnow_event_recv_cb_t *recv_cb = &evt.info.recv_cb;
 
-  if (mac_addr == NULL || data == NULL || len <= 0) {
+  if (mac_addr == NULL || data == NULL || len <= 0 ||
+      len > PACKET_POOL_SLOT_LEN) {
     return;
   }
 
   evt.id = ESPNOW_RECV_CB;
   memcpy(recv_cb->mac_addr, mac_addr, ESP_NOW_ETH_ALEN);
-  recv_cb->data = malloc(len);
-  if (recv_cb->data == NULL) {
-    ESP_LOGE(TAG, "Malloc receive data full.");
+  recv_cb->slot = packet_pool_alloc(&recv_pool);
+  if (recv_cb->slot == NULL) {
     return;
   }
-  memcpy(recv_cb->data, data, len);
-  recv_cb->data_len = len;
+  memcpy(recv_cb->slot->data, data, len);
+  recv_cb->slot->len = len;
   if (xQueueSend(espnow_queue, &evt, ESPNOW_MAXDELAY) != pdTRUE) {
     ESP_LOGW(TAG, "Send receive queue fail.");
-    free(recv_cb->data);
+    packet_pool_free(&recv_pool, recv_cb->slot);
   }
 }
 
@@ -166,9 +292,13 @@ espnow_data_t *espnow_data_parse(uint8_t *data, uint16_t data_len,
   espnow_data_t *buf = (espnow_data_t *)data;
   uint16_t crc, crc_cal = 0;
 
-  if (data_len < sizeof(espnow_data_t)) {
+  espnow_header_check_t check = espnow_header_check(data, data_len);
+  if (check == ESPNOW_HEADER_SHORT) {
     ESP_LOGE(TAG, "Receive ESPNOW data too short, len %d", data_len);
     return NULL;
+  } else if (check != ESPNOW_HEADER_OK) {
+    ESP_LOGD(TAG, "Receive ESPNOW header invalid: %d", check);
+    return NULL;
   }
 
   *seq = buf->seq_num;
@@ -185,41 +315,67 @@ espnow_data_t *espnow_data_parse(uint8_t *data, uint16_t data_len,
 }
 
 void espnow_task(void *pvParam) {
-  if (!is_receiver) {
-    espnow_data_prepare(send_param);
-    espnow_send();
-  }
   for (;;) {
     espnow_tick();
   }
   vTaskDelete(NULL);
 }
 
+void espnow_tx_task(void *pvParam) {
+  // Only waits on audio and on a full window, never on a single send callback
+  for (;;) {
+    espnow_data_prepare(send_param);
+    espnow_send();
+    while (send_param->copies_scheduled > 0) {
+      send_param->copies_scheduled--;
+      espnow_send();
+    }
+    if (send_param->parity_scheduled) {
+      send_param->parity_scheduled = false;
+      espnow_send_buffer(send_param->parity_buffer, send_param->parity_len);
+    }
+#if ESPNOW_CHANNEL_SELECT
+    espnow_channel_update();
+#endif
+  }
+  vTaskDelete(NULL);
+}
+
+void espnow_tx_complete(const espnow_event_send_cb_t *send_cb) {
+  uint8_t slot;
+
+  // Callbacks come in send order. The slot is queued just after esp_now_send
+  // returns, so this only waits when the callback beats it.
+  if (xQueueReceive(tx_in_flight, &slot, ESPNOW_MAXDELAY) != pdTRUE) {
+    ESP_LOGW(TAG, "Send callback without a packet in flight");
+    return;
+  }
+  uint32_t latency = send_cb->time - tx_sent_at[slot];
+  latency_hist_add(&debug.tx_latency, latency);
+  debug.packet_accum += latency;
+  debug.packet_count++;
+  tx_link_sent++;
+  if (send_cb->status != ESP_NOW_SEND_SUCCESS) {
+    debug.tx_failed++;
+    tx_link_failed++;
+  }
+  xQueueSend(tx_free, &slot, 0);
+}
+
 void espnow_tick() {
   espnow_event_t evt;
   uint8_t recv_state = 0;
   uint32_t recv_seq = 0;
-  uint32_t last_recv_seq = 0;
   int recv_magic = 0;
-  bool repeat_packet = false;
 
-  while (xQueueReceive(espnow_queue, &evt, portMAX_DELAY) == pdTRUE) {
+  while (xQueueReceive(espnow_queue, &evt, pdMS_TO_TICKS(ESPNOW_TICK_MS)) ==
+         pdTRUE) {
     switch (evt.id) {
       case ESPNOW_SEND_CB: {
         espnow_event_send_cb_t *send_cb = &evt.info.send_cb;
 
-        if (!is_receiver) {
-          debug.packet_accum += esp_timer_get_time() - debug.packet_sent;
-          debug.packet_count++;
-          if (send_param->resend_scheduled) {
-            send_param->resend_scheduled = false;
-            espnow_send();
-          } else {
-            memcpy(send_param->dest_mac, send_cb->mac_addr, ESP_NOW_ETH_ALEN);
-            espnow_data_prepare(send_param);
-            espnow_send();
-          }
-        }
+        // Receivers send feedback through the same window
+        espnow_tx_complete(send_cb);
 
         break;
       }
@@ -232,111 +388,819 @@ void espnow_tick() {
         debug.micro_count++;
         debug.last_micro = now;
 
+        debug.pool_in_use = packet_pool_in_use(&recv_pool);
+        if (debug.pool_in_use > debug.pool_peak) {
+          debug.pool_peak = debug.pool_in_use;
+        }
+
         espnow_data_t *data =
-            espnow_data_parse(recv_cb->data, recv_cb->data_len, &recv_state,
-                              &recv_seq, &recv_magic);
+            espnow_data_parse(recv_cb->slot->data, recv_cb->slot->len,
+                              &recv_state, &recv_seq, &recv_magic);
+        espnow_source_t *src = NULL;
+        if (data && is_receiver) {
+          espnow_source_expire(now);
+          if (data->type != ESPNOW_PACKET_FEEDBACK) {
+            src = espnow_source_get(recv_cb->mac_addr, now);
+          }
+        }
         if (data) {
-          if (is_receiver) {
-            uint16_t seq_diff = recv_seq - last_recv_seq;
-            if (seq_diff == 0) {
-              repeat_packet = true;
-            } else if (seq_diff != 1 && recv_seq != 0) {
-              if (recv_seq < last_recv_seq) {
-                ESP_LOGW(TAG, "Received stale packet: %u", recv_seq);
-              } else {
-                debug.missed_packet_count += seq_diff - 1;
-              }
+          if (data->type == ESPNOW_PACKET_FEEDBACK) {
+            if (!is_receiver) {
+              espnow_feedback_recv((espnow_feedback_t *)data->payload);
+            }
+          } else if (data->type == ESPNOW_PACKET_CHANNEL) {
+            if (src != NULL && espnow_source_primary(src)) {
+              const espnow_channel_switch_t *sw =
+                  (const espnow_channel_switch_t *)data->payload;
+              channel_follow_announce(&channel_follow, sw->channel,
+                                      sw->switch_seq);
             }
-            if (is_receiver && espnow_rbuf != NULL && !repeat_packet) {
-              if (espnow_data_state == ESPNOW_RBUF_ACTIVE) {
-                if (xRingbufferSend(espnow_rbuf, data->payload, ESPNOW_SEND_LEN,
-                                    portMAX_DELAY) != pdTRUE) {
-                  ESP_LOGE(TAG, "Failed to send to ringbuffer");
-                }
+          } else if (src != NULL) {
+            espnow_stream_update(src, data);
+            espnow_fec_recover(src, data, recv_cb->slot->len);
+            if (data->type == ESPNOW_PACKET_AUDIO) {
+              espnow_feedback_count(src, data);
+              if (jitter_buffer_insert(&src->jitter, recv_seq,
+                                       recv_cb->slot) ==
+                  JITTER_BUFFER_INSERTED) {
+                recv_cb->slot = NULL;
               }
-              debug.ringbuffer_accum += xRingbufferGetCurFreeSize(espnow_rbuf);
-              debug.ringbuffer_count++;
             }
-            last_recv_seq = recv_seq;
-            repeat_packet = false;
+            espnow_playout(src);
+            espnow_mix();
+            espnow_feedback_send(src);
+            if (espnow_source_primary(src)) {
+              espnow_channel_move(channel_follow_packet(
+                  &channel_follow, recv_seq, now / 1000));
+            }
           }
         } else {
           ESP_LOGE(TAG, "Receive error data from: " MACSTR "",
                    MAC2STR(recv_cb->mac_addr));
         }
-        free(recv_cb->data);
+        if (recv_cb->slot != NULL) {
+          packet_pool_free(&recv_pool, recv_cb->slot);
+        }
         break;
       }
       default:
         ESP_LOGE(TAG, "Callback type error: %d", evt.id);
         break;
     }
+    espnow_housekeeping();
 #if ESPNOW_LOGGING
     espnow_print_debug();
 #endif
   }
+  // Nothing arrived for ESPNOW_TICK_MS
+  espnow_housekeeping();
+}
+
+void espnow_housekeeping() {
+  if (is_receiver) {
+    espnow_channel_tick();
+  } else {
+#if ESPNOW_RATE_ADAPT
+    espnow_rate_set(
+        rate_ctrl_tick(&rate_ctrl, esp_timer_get_time() / 1000));
+#endif
+  }
+}
+
+// Receivers follow the channel of the lowest numbered source, others on
+// the old channel are lost until they migrate too
+bool espnow_source_primary(const espnow_source_t *src) {
+  for (const espnow_source_t *s = sources; s < src; s++) {
+    if (s->active) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void espnow_channel_move(uint8_t channel) {
+  if (channel == 0) {
+    return;
+  }
+  esp_err_t err = war_wifi_set_channel(channel);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Channel %u: %s", channel, esp_err_to_name(err));
+    return;
+  }
+  debug.channel_moves++;
+}
+
+void espnow_rate_set(rate_t rate) {
+  static rate_t set = ESPNOW_RATE;
+
+  if (rate != set && war_wifi_set_rate(rate) == ESP_OK) {
+    set = rate;
+  }
+}
+
+void espnow_channel_tick() {
+  espnow_channel_move(
+      channel_follow_tick(&channel_follow, esp_timer_get_time() / 1000));
+}
+
+// The lowest numbered source with a stream sets the rate the sinks run at;
+// sources at another rate are not mixed
+static void espnow_mix_rate_update() {
+  espnow_source_t *first = NULL;
+  for (int i = 0; i < ESPNOW_MAX_SOURCES && first == NULL; i++) {
+    if (sources[i].active && sources[i].stream_valid) {
+      first = &sources[i];
+    }
+  }
+  uint32_t rate = first != NULL ? first->stream.sample_rate : 0;
+  if (rate != mix_rate) {
+    mix_rate = rate;
+    if (first != NULL && format_cb != NULL) {
+      format_cb(&first->stream);
+    }
+  }
+}
+
+static void espnow_source_stop(espnow_source_t *src) {
+  ESP_LOGI(TAG, "Source %d left: " MACSTR, src - sources, MAC2STR(src->mac));
+  jitter_buffer_reset(&src->jitter);
+  mixer_set_active(&mixer, src - sources, false);
+  src->active = false;
+  espnow_mix_rate_update();
+}
+
+espnow_source_t *espnow_source_get(const uint8_t *mac, int64_t now) {
+  espnow_source_t *src = NULL;
+
+  for (int i = 0; i < ESPNOW_MAX_SOURCES; i++) {
+    if (sources[i].active &&
+        memcmp(sources[i].mac, mac, ESP_NOW_ETH_ALEN) == 0) {
+      sources[i].last_heard = now;
+      return &sources[i];
+    }
+    if (!sources[i].active && src == NULL) {
+      src = &sources[i];
+    }
+  }
+  if (src == NULL) {
+    debug.sources_rejected++;
+    return NULL;
+  }
+
+  memset(src, 0, sizeof(espnow_source_t));
+  memcpy(src->mac, mac, ESP_NOW_ETH_ALEN);
+  jitter_buffer_init(&src->jitter, JITTER_BUFFER_DEPTH, espnow_release_slot,
+                     &recv_pool);
+  fec_decoder_init(&src->fec_dec);
+  mixer_set_active(&mixer, src - sources, true);
+  src->last_heard = now;
+  src->active = true;
+  ESP_LOGI(TAG, "Source %d joined: " MACSTR, src - sources, MAC2STR(mac));
+  return src;
+}
+
+void espnow_source_expire(int64_t now) {
+  for (int i = 0; i < ESPNOW_MAX_SOURCES; i++) {
+    if (sources[i].active &&
+        now - sources[i].last_heard > ESPNOW_SOURCE_TIMEOUT_MS * 1000) {
+      espnow_source_stop(&sources[i]);
+    }
+  }
+}
+
+AUDIO_HOT void espnow_stream_update(espnow_source_t *src, espnow_data_t *data) {
+  espnow_stream_format_t *stream = &src->stream;
+
+  if (src->stream_valid && data->codec == stream->codec &&
+      data->format == stream->format && data->channels == stream->channels &&
+      data->sample_rate == stream->sample_rate &&
+      data->frame_len == stream->frame_len) {
+    return;
+  }
+
+  // Frames held for the old stream must not be played out as the new one
+  if (src->stream_valid) {
+    debug.format_changes++;
+    jitter_buffer_reset(&src->jitter);
+    fec_decoder_init(&src->fec_dec);
+  }
+  stream->codec = data->codec;
+  stream->format = data->format;
+  stream->channels = data->channels;
+  stream->sample_rate = data->sample_rate;
+  stream->frame_len = data->frame_len;
+  src->stream_valid = true;
+  src->timestamp_valid = false;
+
+  ESP_LOGI(TAG,
+           "Source %d stream: codec %u, format %u, %u ch, %u Hz, %u "
+           "samples/packet",
+           src - sources, stream->codec, stream->format, stream->channels,
+           stream->sample_rate, stream->frame_len);
+  espnow_mix_rate_update();
+}
+
+AUDIO_HOT void espnow_fec_recover(espnow_source_t *src, espnow_data_t *data,
+                        uint16_t len) {
+  uint32_t lost_seq;
+  const uint8_t *lost_payload;
+  uint16_t lost_len;
+
+  if (data->fec_k == 0 ||
+      !fec_decoder_add(&src->fec_dec, data->seq_num, data->fec_k,
+                       data->type == ESPNOW_PACKET_PARITY, data->payload,
+                       len - sizeof(espnow_data_t), &lost_seq, &lost_payload,
+                       &lost_len)) {
+    return;
+  }
+
+  packet_slot_t *slot = packet_pool_alloc(&recv_pool);
+  if (slot == NULL) {
+    return;
+  }
+  // Packets of a group share everything but sequence number and timestamp
+  espnow_data_t *rebuilt = (espnow_data_t *)slot->data;
+  *rebuilt = *data;
+  rebuilt->seq_num = lost_seq;
+  rebuilt->crc = 0;
+  rebuilt->type = ESPNOW_PACKET_AUDIO;
+  rebuilt->timestamp =
+      data->timestamp + (int64_t)(int32_t)(lost_seq - data->seq_num) *
+                            data->frame_len;
+  memcpy(rebuilt->payload, lost_payload, lost_len);
+  slot->len = sizeof(espnow_data_t) + lost_len;
+
+  if (jitter_buffer_insert(&src->jitter, lost_seq, slot) ==
+      JITTER_BUFFER_INSERTED) {
+    debug.fec_recovered++;
+  } else {
+    packet_pool_free(&recv_pool, slot);
+  }
+}
+
+AUDIO_HOT void espnow_playout(espnow_source_t *src) {
+  void *frame;
+  uint32_t seq;
+  jitter_buffer_pop_t pop;
+
+  while ((pop = jitter_buffer_pop(&src->jitter, &frame, &seq)) !=
+         JITTER_BUFFER_WAIT) {
+    if (pop == JITTER_BUFFER_LOST) {
+      debug.missed_packet_count++;
+      src->missed++;
+      src->next_timestamp += src->stream.frame_len;
+      continue;
+    }
+
+    packet_slot_t *slot = (packet_slot_t *)frame;
+    const void *samples;
+    espnow_data_t *data = (espnow_data_t *)slot->data;
+    size_t n = espnow_decode(data, slot->len - sizeof(espnow_data_t), &samples);
+    if (src->timestamp_valid && data->timestamp != src->next_timestamp) {
+      debug.timestamp_jumps++;
+    }
+    src->next_timestamp = data->timestamp + data->frame_len;
+    src->timestamp_valid = true;
+    src->received++;
+
+    if (n == 0 || n != data->frame_len * data->channels) {
+      debug.missed_packet_count++;
+      src->missed++;
+    } else if (data->sample_rate != mix_rate) {
+      debug.rate_mismatch++;
+    } else {
+      uint8_t bytes = data->codec == ESPNOW_CODEC_PCM
+                          ? ESPNOW_FORMAT_BYTES(data->format)
+                          : sizeof(int16_t);
+      // Packets already in the sink format go straight to the mixer
+      if (data->channels != AUDIO_CHANNELS ||
+          bytes != sizeof(audio_sample_t)) {
+        n = audio_convert(samples, bytes, data->channels, data->frame_len,
+                          rx_audio);
+        samples = rx_audio;
+      }
+      mixer_write(&mixer, src - sources, samples, n);
+    }
+    packet_pool_free(&recv_pool, slot);
+  }
+}
+
+AUDIO_HOT void espnow_mix() {
+  while (mixer_mix(&mixer, mix_out) > 0) {
+    if (espnow_rbuf != NULL) {
+      ringbuf_bcast_write(espnow_rbuf, mix_out, MIXER_FRAME * AUDIO_CHANNELS);
+      debug.ringbuffer_accum += ringbuf_bcast_avail(espnow_rbuf);
+      debug.ringbuffer_count++;
+    }
+  }
+}
+
+AUDIO_HOT size_t espnow_decode(espnow_data_t *data, size_t len, const void **samples) {
+  switch (data->codec) {
+    case ESPNOW_CODEC_PCM:
+      *samples = data->payload;
+      return len / ESPNOW_FORMAT_BYTES(data->format);
+    case ESPNOW_CODEC_ADPCM:
+      *samples = rx_pcm;
+      return adpcm_decode(data->payload, len, rx_pcm);
+    case ESPNOW_CODEC_LOSSLESS:
+      *samples = rx_pcm;
+      return lossless_decode(data->payload, len, rx_pcm,
+                             sizeof(rx_pcm) / sizeof(int16_t));
+    default:
+      return 0;
+  }
 }
 
 void espnow_data_prepare(espnow_send_param_t *param) {
   espnow_data_t *buf = (espnow_data_t *)send_param->buffer;
 
-  assert(send_param->len >= sizeof(espnow_data_t));
+  // Redundancy only changes between FEC groups, and FEC only starts on a
+  // group boundary, seq_num % ESPNOW_FEC_K == 0, where the receiver looks
+  if (fec_enc.count == 0 &&
+      (tx_level_next != REDUNDANCY_FEC ||
+       espnow_seq[0] % ESPNOW_FEC_GROUP == 0)) {
+    tx_level = tx_level_next;
+  }
 
-  buf->seq_num = espnow_seq[0]++;
+  // Stage the next 1 ms frames once the previous ones have all been sent
+  if (tx_sent == tx_staged) {
+    // Only change duration between FEC groups, so a rebuilt packet has the
+    // duration of the parity packet that rebuilt it
+    if (fec_enc.count == 0) {
+      param->frames = tx_frames_next;
+    }
+    for (int i = 0; i < param->frames; i++) {
+      xQueueReceive(espnow_data_queue,
+                    &tx_pcm[i * ESPNOW_FRAME_SAMPLES * AUDIO_CHANNELS],
+                    portMAX_DELAY);
+    }
+    tx_staged = param->frames * ESPNOW_FRAME_SAMPLES;
+    tx_sent = 0;
+    tx_part = tx_staged / espnow_packet_parts(param->frames, ESPNOW_CODEC);
+  }
+  const audio_sample_t *pcm = &tx_pcm[tx_sent * AUDIO_CHANNELS];
+  size_t n = tx_part;
+  size_t payload_len = n * AUDIO_CHANNELS * sizeof(audio_sample_t);
+  tx_sent += n;
+
+  buf->version = ESPNOW_VERSION;
+  buf->type = ESPNOW_PACKET_AUDIO;
+  buf->codec = ESPNOW_CODEC;
+  buf->format = AUDIO_BYTES_PER_SAMPLE == 4 ? ESPNOW_FORMAT_S24_32
+                                            : ESPNOW_FORMAT_S16;
+  buf->channels = AUDIO_CHANNELS;
+  buf->fec_k = tx_level == REDUNDANCY_FEC ? ESPNOW_FEC_K : 0;
   buf->crc = 0;
+  buf->seq_num = espnow_seq[0]++;
+  buf->sample_rate = SAMPLERATE;
+  buf->timestamp = tx_timestamp;
+  buf->frame_len = n;
+  buf->copies = redundancy_copies(tx_level);
+  buf->reserved = 0;
+  tx_timestamp += n;
 
-  xQueueReceive(espnow_data_queue, buf->payload, portMAX_DELAY);
+  // The static assert above keeps the compressed codecs on int16_t samples
+  if (ESPNOW_CODEC == ESPNOW_CODEC_ADPCM) {
+    payload_len =
+        adpcm_encode(&adpcm_enc, (const int16_t *)pcm, n, buf->payload);
+  } else if (ESPNOW_CODEC == ESPNOW_CODEC_LOSSLESS) {
+    payload_len = lossless_encode((const int16_t *)pcm, n, buf->payload);
+  } else {
+    memcpy(buf->payload, pcm, payload_len);
+  }
+  send_param->len = sizeof(espnow_data_t) + payload_len;
+  assert(send_param->len <= ESPNOW_BUFFER_LEN);
+
+  if (buf->fec_k && fec_enc.count == 0) {
+    tx_group_timestamp = buf->timestamp;
+  }
+  if (buf->fec_k &&
+      fec_encoder_add(&fec_enc, ESPNOW_FEC_K, buf->payload, payload_len)) {
+    // Parity carries the header of the group's first packet
+    espnow_data_t *parity = (espnow_data_t *)send_param->parity_buffer;
+    *parity = *buf;
+    parity->seq_num = buf->seq_num - (ESPNOW_FEC_K - 1);
+    parity->timestamp = tx_group_timestamp;
+    parity->type = ESPNOW_PACKET_PARITY;
+    memcpy(parity->payload, fec_enc.parity, fec_enc.len);
+    send_param->parity_len = sizeof(espnow_data_t) + fec_enc.len;
+    parity->crc = esp_crc16_le(UINT16_MAX, (uint8_t const *)parity,
+                               send_param->parity_len);
+    send_param->parity_scheduled = true;
+  }
 
   buf->crc = esp_crc16_le(UINT16_MAX, (uint8_t const *)buf, send_param->len);
 
-  send_param->resend_scheduled = true;
+  send_param->copies_scheduled = buf->copies;
+}
+
+void espnow_feedback_count(espnow_source_t *src, const espnow_data_t *data) {
+  espnow_feedback_t *feedback = &src->feedback;
+
+  feedback->received++;
+  // Everything sent over the sequence numbers seen, at the copies each
+  // packet says it was sent with. Large jumps are a restarted transmitter.
+  int32_t ahead = data->seq_num - src->feedback_newest_seq;
+  if (!src->feedback_started || ahead > 64) {
+    feedback->expected += 1 + data->copies;
+    src->feedback_newest_seq = data->seq_num;
+    src->feedback_started = true;
+  } else if (ahead > 0) {
+    feedback->expected += ahead * (1 + data->copies);
+    src->feedback_newest_seq = data->seq_num;
+  }
+}
+
+void espnow_feedback_send(espnow_source_t *src) {
+  espnow_feedback_t *feedback = &src->feedback;
+  jitter_buffer_stats_t *stats = &src->jitter.stats;
+
+  int64_t now = esp_timer_get_time();
+  if (now - src->feedback_sent < ESPNOW_FEEDBACK_MS * 1000) {
+    return;
+  }
+  // This task retires the window, so never wait on it from here. Without a
+  // free slot nothing is taken from the counts, they go in the next report.
+  if (uxQueueMessagesWaiting(tx_free) == 0) {
+    return;
+  }
+
+  feedback->lost = stats->lost - src->feedback_jitter.lost;
+  feedback->late = stats->late - src->feedback_jitter.late;
+  feedback->reordered = stats->reordered - src->feedback_jitter.reordered;
+  memcpy(feedback->source, src->mac, ESP_NOW_ETH_ALEN);
+  war_wifi_link_quality(&feedback->rssi, &feedback->noise);
+
+  uint8_t packet[sizeof(espnow_data_t) + sizeof(espnow_feedback_t)]
+      __attribute__((aligned(4)));
+  espnow_data_t *buf = (espnow_data_t *)packet;
+  memset(buf, 0, sizeof(espnow_data_t));
+  buf->version = ESPNOW_VERSION;
+  buf->type = ESPNOW_PACKET_FEEDBACK;
+  buf->seq_num = espnow_seq[1]++;
+  memcpy(buf->payload, feedback, sizeof(espnow_feedback_t));
+  buf->crc = esp_crc16_le(UINT16_MAX, packet, sizeof(packet));
+  espnow_send_buffer(packet, sizeof(packet));
+  debug.feedback_count++;
+
+  // Only a report handed to the driver starts the next interval
+  src->feedback_sent = now;
+  src->feedback_jitter = *stats;
+  memset(feedback, 0, sizeof(espnow_feedback_t));
 }
 
-void espnow_send() {
-  esp_err_t err =
-      esp_now_send(send_param->dest_mac, send_param->buffer, send_param->len);
+void espnow_feedback_recv(const espnow_feedback_t *report) {
+  static uint32_t dropped_seen;
+  static uint32_t bytes_seen;
+  static int64_t last_report;
+
+  if (memcmp(report->source, own_mac, ESP_NOW_ETH_ALEN) != 0) {
+    return;
+  }
+  debug.feedback_count++;
+
+  if (report->expected > 0) {
+    uint32_t dropped = tx_link_dropped - dropped_seen;
+    uint32_t attempts = tx_link_sent + dropped;
+    channel_link_sample_t sample = {
+        .loss_permille = report->received < report->expected
+                             ? (uint64_t)(report->expected - report->received) *
+                                   1000 / report->expected
+                             : 0,
+        .retry_permille =
+            attempts ? (uint64_t)(tx_link_failed + dropped) * 1000 / attempts
+                     : 0,
+        .rssi = report->rssi,
+        .noise = report->noise,
+    };
+    xQueueOverwrite(tx_link, &sample);
+
+#if ESPNOW_RATE_ADAPT
+    int64_t now = esp_timer_get_time();
+    uint32_t bytes = tx_link_bytes - bytes_seen;
+    if (tx_link_sent > 0 && now > last_report) {
+      rate_ctrl_set_load(&rate_ctrl, bytes / tx_link_sent,
+                         (uint64_t)tx_link_sent * 1000000 / (now - last_report));
+    }
+    espnow_rate_set(rate_ctrl_report(&rate_ctrl, report->received,
+                                     report->expected, attempts,
+                                     tx_link_failed + dropped, now / 1000));
+    bytes_seen += bytes;
+    last_report = now;
+#endif
+    dropped_seen += dropped;
+    tx_link_sent = tx_link_failed = 0;
+  }
+
+#if ESPNOW_ADAPTIVE_REDUNDANCY
+  tx_level_next = redundancy_update(&redundancy, report->received,
+                                    report->expected, report->lost);
+#endif
+}
+
+// Packets ms of audio is sent in, 0 if it can not be sent. PCM is split into
+// equal parts when it does not fit one packet, the compressed codecs are not.
+uint8_t espnow_packet_parts(uint8_t ms, uint8_t codec) {
+  size_t frames = ms * ESPNOW_FRAME_SAMPLES;
+  size_t room = ESPNOW_BUFFER_LEN - sizeof(espnow_data_t);
+
+  // 1, 2, 4... ms so the packet rate stays a whole number
+  if (ms == 0 || ms > MAX_MS_PER_PACKET || (ms & (ms - 1)) != 0) {
+    return 0;
+  }
+  if (ESPNOW_FEC_K) {
+    room -= FEC_PARITY_HEADER;
+  }
+  switch (codec) {
+    case ESPNOW_CODEC_PCM:
+      for (size_t parts = 1; parts <= frames; parts++) {
+        if (frames % parts == 0 &&
+            frames / parts * AUDIO_CHANNELS * sizeof(audio_sample_t) <=
+                room) {
+          return parts;
+        }
+      }
+      return 0;
+    case ESPNOW_CODEC_ADPCM:
+      return ADPCM_ENCODED_LEN(frames) <= room;
+    case ESPNOW_CODEC_LOSSLESS:
+      return LOSSLESS_MAX_LEN(frames) <= room;
+    default:
+      return 0;
+  }
+}
+
+esp_err_t espnow_set_packet_ms(uint8_t ms) {
+  if (espnow_packet_parts(ms, ESPNOW_CODEC) == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  tx_frames_next = ms;
+  return ESP_OK;
+}
+
+void espnow_print_packet_model() {
+  packet_model_t model;
+
+  for (uint8_t ms = 1; ms <= MAX_MS_PER_PACKET; ms++) {
+    uint8_t parts = espnow_packet_parts(ms, ESPNOW_CODEC);
+    if (parts == 0) {
+      continue;
+    }
+    // Lossless blocks vary, model them at their PCM size
+    size_t frames = ms * ESPNOW_FRAME_SAMPLES / parts;
+    size_t payload_len = frames * AUDIO_CHANNELS * sizeof(audio_sample_t);
+    if (ESPNOW_CODEC == ESPNOW_CODEC_ADPCM) {
+      payload_len = ADPCM_ENCODED_LEN(frames);
+    }
+    packet_model(ms, parts, sizeof(espnow_data_t), payload_len,
+                 tx_level == REDUNDANCY_FEC ? ESPNOW_FEC_K : 0,
+                 redundancy_copies(tx_level), JITTER_BUFFER_DEPTH, &model);
+    ESP_LOGI(TAG,
+             "%u ms in %u packets: %u packets/s, %u bytes on air, "
+             "%u.%u%% header, %u-%u us latency",
+             ms, parts, model.packets_per_sec, model.air_bytes,
+             model.overhead_permille / 10, model.overhead_permille % 10,
+             model.latency_us, model.worst_latency_us);
+  }
+}
+
+void espnow_send() { espnow_send_buffer(send_param->buffer, send_param->len); }
+
+void espnow_send_buffer(uint8_t *buffer, int len) {
+  uint8_t slot;
+
+  // Blocks only while the whole window is with the driver
+  xQueueReceive(tx_free, &slot, portMAX_DELAY);
+  memcpy(tx_slots[slot], buffer, len);
+  tx_sent_at[slot] = esp_timer_get_time();
+  esp_err_t err = esp_now_send(send_param->dest_mac, tx_slots[slot], len);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "ESP-Now Send Error: %s", esp_err_to_name(err));
-    if (err != ESP_ERR_ESPNOW_NO_MEM) {
-      espnow_deinit(send_param);
-      vTaskDelete(NULL);
+    xQueueSend(tx_free, &slot, 0);
+    if (err == ESP_ERR_ESPNOW_NO_MEM) {
+      debug.tx_dropped++;
+      tx_link_dropped++;
+      return;
     }
+    ESP_LOGE(TAG, "ESP-Now Send Error: %s", esp_err_to_name(err));
+    espnow_deinit(send_param);
+    vTaskDelete(NULL);
   } else {
-    debug.tx_byte_count += send_param->len;
-    debug.packet_sent = esp_timer_get_time();
+    xQueueSend(tx_in_flight, &slot, 0);
+    debug.tx_byte_count += len;
+    tx_link_bytes += len;
   }
 }
 
+// Waits until the driver has sent everything in the window, so nothing
+// queued goes out after the radio leaves the channel
+static void espnow_tx_drain() {
+  uint8_t slots[ESPNOW_TX_WINDOW];
+
+  for (int i = 0; i < ESPNOW_TX_WINDOW; i++) {
+    xQueueReceive(tx_free, &slots[i], portMAX_DELAY);
+  }
+  for (int i = 0; i < ESPNOW_TX_WINDOW; i++) {
+    xQueueSend(tx_free, &slots[i], 0);
+  }
+}
+
+void espnow_channel_announce() {
+  uint8_t packet[sizeof(espnow_data_t) + sizeof(espnow_channel_switch_t)]
+      __attribute__((aligned(4)));
+  espnow_data_t *buf = (espnow_data_t *)packet;
+  espnow_channel_switch_t *sw = (espnow_channel_switch_t *)buf->payload;
+
+  memset(packet, 0, sizeof(packet));
+  buf->version = ESPNOW_VERSION;
+  buf->type = ESPNOW_PACKET_CHANNEL;
+  buf->seq_num = espnow_seq[1]++;
+  sw->channel = tx_switch_channel;
+  sw->switch_seq = tx_switch_seq;
+  buf->crc = esp_crc16_le(UINT16_MAX, packet, sizeof(packet));
+  espnow_send_buffer(packet, sizeof(packet));
+}
+
+// Runs on the TX task between packets. A probe leaves the channel for
+// WAR_WIFI_PROBE_DWELL_MS, so probes only happen while the link is already
+// degraded, and the receivers' jitter buffers and concealment cover them.
+void espnow_channel_update() {
+  int64_t now_ms = esp_timer_get_time() / 1000;
+  uint32_t next_seq = espnow_seq[0];
+  channel_link_sample_t sample;
+
+  if (xQueueReceive(tx_link, &sample, 0) == pdTRUE) {
+    channel_ctrl_link(&channel_ctrl, &sample);
+  }
+
+  if (tx_switch_channel != 0) {
+    if (next_seq == tx_switch_seq) {
+      espnow_tx_drain();
+      if (war_wifi_set_channel(tx_switch_channel) == ESP_OK) {
+        channel_ctrl_switched(&channel_ctrl, tx_switch_channel, now_ms);
+        debug.channel_moves++;
+      } else {
+        ESP_LOGE(TAG, "Channel %u: switch failed", tx_switch_channel);
+      }
+      tx_switch_channel = 0;
+    } else if ((tx_switch_seq - next_seq) % (ESPNOW_CHANNEL_LEAD / 4) == 0) {
+      espnow_channel_announce();
+    }
+    return;
+  }
+
+  uint8_t probe_channel = channel_ctrl_next_probe(&channel_ctrl, now_ms);
+  if (probe_channel != 0) {
+    channel_probe_t probe;
+    espnow_tx_drain();
+    if (war_wifi_probe(probe_channel, &probe) == ESP_OK) {
+      channel_ctrl_probed(&channel_ctrl, probe_channel, &probe, now_ms);
+    }
+  }
+
+  uint8_t target = channel_ctrl_pick(&channel_ctrl, now_ms);
+  if (target != 0) {
+    // Switch on an FEC group boundary so no group spans both channels
+    uint32_t seq = next_seq + ESPNOW_CHANNEL_LEAD;
+    tx_switch_seq = seq + (ESPNOW_FEC_GROUP - seq % ESPNOW_FEC_GROUP) %
+                              ESPNOW_FEC_GROUP;
+    tx_switch_channel = target;
+    ESP_LOGI(TAG, "Channel %u scores %u, moving to %u (%u) at packet %u",
+             channel_ctrl.current,
+             channel_ctrl_score(&channel_ctrl, channel_ctrl.current), target,
+             channel_ctrl_score(&channel_ctrl, target), tx_switch_seq);
+  }
+}
+
+// num / den in tenths, 0 before anything was counted
+static uint32_t espnow_tenths(uint64_t num, uint64_t den) {
+  return den == 0 ? 0 : num * 10 / den;
+}
+
 void espnow_print_debug() {
   int64_t now = esp_timer_get_time();
   int64_t diff = now - debug.time;
   if (diff >= debug.interval) {
     debug.time = now;
-    float rbuf_bytes_free_avg =
-        (float)debug.ringbuffer_accum / debug.ringbuffer_count;
+    // Integer tenths throughout, float is soft float on the S2
+    uint32_t tx_kbps = espnow_tenths((uint64_t)debug.tx_byte_count * 1000, diff);
+    uint32_t rx_kbps = espnow_tenths((uint64_t)debug.rx_byte_count * 1000, diff);
+    uint32_t missed = espnow_tenths((uint64_t)debug.missed_packet_count * 1000,
+                                    debug.total_packet_count);
+    uint32_t rbuf_free = espnow_tenths(debug.ringbuffer_accum,
+                                       debug.ringbuffer_count);
+    uint32_t rbuf_pct = espnow_tenths((uint64_t)debug.ringbuffer_accum * 100,
+                                      (uint64_t)debug.ringbuffer_count *
+                                          RINGBUF_BCAST_CAPACITY);
+    uint32_t rx_cb = espnow_tenths(debug.micro_accum, debug.micro_count);
+    uint32_t send_delay = espnow_tenths(debug.packet_accum, debug.packet_count);
+    uint32_t pool_exhausted = packet_pool_take_exhausted(&recv_pool);
+    uint32_t active = 0, unrecoverable = 0;
+    for (int i = 0; i < ESPNOW_MAX_SOURCES; i++) {
+      if (sources[i].active) {
+        active++;
+        unrecoverable += sources[i].fec_dec.stats.unrecoverable;
+      }
+    }
     ESP_LOGI(
         TAG,
-        "\nTX: %0.1fKBps, RX: %0.1fKbps\n"
-        "Missed %0.2f%%(%u) of packets\n"
-        "Audio Ringbuffer Avg: %0.1f%% (%0.1fB Free)\n"
-        "RX CB: %0.1f\n"
+        "\nTX: %u.%uKBps, RX: %u.%uKbps\n"
+        "Missed %u.%02u%%(%u) of packets\n"
+        "Audio Ringbuffer Avg: %u.%u%% (%u.%u Samples Free)\n"
+        "RX CB: %u.%u\n"
         "Missed USB Audio CBs: %u\n"
-        "Send/CB Delay: %0.1f(%u)",
-        ((float)debug.tx_byte_count * 0.001f) / (diff * 0.000001f),
-        ((float)debug.rx_byte_count * 0.001f) / (diff * 0.000001f),
-        ((float)debug.missed_packet_count / (float)debug.total_packet_count) *
-            100.f,
-        debug.missed_packet_count,
-        (rbuf_bytes_free_avg / (float)espnow_rbuf_len) * 100.f,
-        rbuf_bytes_free_avg, (float)debug.micro_accum / debug.micro_count,
-        debug.missed_audio_cb, (float)debug.packet_accum / debug.packet_count,
-        debug.packet_count);
+        "Packet Pool: %u/%u in use (peak %u), %u exhausted\n"
+        "FEC: %u recovered, %u unrecoverable\n"
+        "Sources: %u active, mixing at %u Hz, %u format changes, "
+        "%u timestamp jumps, %u rejected, %u at another rate\n"
+        "Sink time max: USB CB %u us (%u cycles), I2S %u us\n"
+        "Sink drift: USB %d ppm, I2S %d ppm\n"
+        "TX: %u packets/s, %u failed, %u dropped\n"
+        "Send/CB Delay: avg %u.%u, p50 %u, p90 %u, p99 %u, max %u us (%u)",
+        tx_kbps / 10, tx_kbps % 10, rx_kbps / 10, rx_kbps % 10, missed / 100,
+        missed % 100, debug.missed_packet_count, rbuf_pct / 10, rbuf_pct % 10,
+        rbuf_free / 10, rbuf_free % 10, rx_cb / 10, rx_cb % 10,
+        debug.missed_audio_cb, debug.pool_in_use, PACKET_POOL_SIZE,
+        debug.pool_peak, pool_exhausted, debug.fec_recovered,
+        unrecoverable, active, mix_rate, debug.format_changes,
+        debug.timestamp_jumps, debug.sources_rejected, debug.rate_mismatch,
+        debug.usb_cb_us_max, debug.usb_cb_cycles_max, debug.i2s_us_max,
+        debug.usb_drift_ppm, debug.i2s_drift_ppm,
+        (uint32_t)(debug.packet_count * 1000000LL / diff), debug.tx_failed,
+        debug.tx_dropped, send_delay / 10, send_delay % 10,
+        latency_hist_percentile(&debug.tx_latency, 500),
+        latency_hist_percentile(&debug.tx_latency, 900),
+        latency_hist_percentile(&debug.tx_latency, 990),
+        debug.tx_latency.max_us, debug.packet_count);
+
+    uint32_t loss = redundancy.loss_avg >> 4;
+    ESP_LOGI(TAG,
+             "Redundancy: %s, %u.%u%% loss on air, %u raises, %u drops, "
+             "%u feedback reports",
+             redundancy_level_name(tx_level), loss / 10, loss % 10,
+             redundancy.stats.raises, redundancy.stats.drops,
+             debug.feedback_count);
+
+    if (!is_receiver) {
+      uint32_t airtime =
+          (uint64_t)rate_ctrl_airtime_us(rate_ctrl.active, rate_ctrl.bytes) *
+          rate_ctrl.packets_per_s / 1000;
+      ESP_LOGI(TAG,
+               "PHY rate: %u Mbps, %u.%u%% airtime, %u samples, %u changes",
+               rate_ctrl_kbps(rate_ctrl.active) / 1000, airtime / 10,
+               airtime % 10, rate_ctrl.stats.samples, rate_ctrl.stats.changes);
+    }
+
+    uint8_t channel = is_receiver ? channel_follow.current : channel_ctrl.current;
+    ESP_LOGI(TAG, "Channel: %u, score %u, %u probes, %u moves", channel,
+             channel_ctrl_score(&channel_ctrl, channel),
+             channel_ctrl.stats.probes, debug.channel_moves);
+
+    for (int i = 0; i < ESPNOW_MAX_SOURCES; i++) {
+      espnow_source_t *src = &sources[i];
+      if (!src->active) {
+        continue;
+      }
+      jitter_buffer_stats_t *stats = &src->jitter.stats;
+      ESP_LOGI(TAG,
+               "Source %d " MACSTR ": %u Hz, %u ch, %u samples/packet, "
+               "%u received, %u missed, jitter %u reordered, %u late, "
+               "%u duplicate, %u resync, %u frames lagged in the mix",
+               i, MAC2STR(src->mac), src->stream.sample_rate,
+               src->stream.channels, src->stream.frame_len, src->received,
+               src->missed, stats->reordered, stats->late, stats->duplicate,
+               stats->resync, mixer.inputs[i].lagged);
+      src->received = src->missed = 0;
+      src->fec_dec.stats.unrecoverable = 0;
+      mixer.inputs[i].lagged = 0;
+    }
+
+    if (espnow_rbuf != NULL) {
+      for (int i = 0; i < RINGBUF_BCAST_MAX_READERS; i++) {
+        ringbuf_bcast_reader_t *reader = &espnow_rbuf->readers[i];
+        if (reader->active) {
+          ESP_LOGI(TAG, "Sink %d: %u underruns, %u overruns", i,
+                   reader->underruns, reader->overruns);
+        }
+      }
+    }
 
     debug.rx_byte_count = debug.tx_byte_count = 0;
     debug.total_packet_count = debug.missed_packet_count = 0;
     debug.ringbuffer_accum = debug.ringbuffer_count = 0;
     debug.micro_accum = debug.micro_count = 0;
     debug.missed_audio_cb = 0;
+    debug.pool_peak = 0;
+    debug.fec_recovered = 0;
     debug.packet_accum = debug.packet_count = 0;
+    debug.tx_failed = debug.tx_dropped = 0;
+    latency_hist_reset(&debug.tx_latency);
+    debug.feedback_count = 0;
+    debug.sources_rejected = debug.rate_mismatch = 0;
+    debug.channel_moves = 0;
+
+    debug.format_changes = debug.timestamp_jumps = 0;
+    debug.usb_cb_us_max = debug.usb_cb_cycles_max = debug.i2s_us_max = 0;
+
   }
 }
\ No newline at end of file
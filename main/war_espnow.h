@@ -4,14 +4,27 @@
 #include "esp_now.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include "freertos/ringbuf.h"
+#include "ringbuf_bcast.h"
+#include "packet_pool.h"
+#include "fec_xor.h"
+#include "adpcm.h"
+#include "lossless.h"
+#include "espnow_proto.h"
+#include "audio_format.h"
+#include "latency_hist.h"
+#include "jitter_buffer.h"
+#include "mixer.h"
+#include "rate_ctrl.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define ESPNOW_QUEUE_SIZE           12
-#define ESPNOW_DATA_QUEUE_SIZE      5
+#define ESPNOW_DATA_QUEUE_SIZE      10              // 1 ms frames of audio waiting to be sent
+#define ESPNOW_TX_WINDOW            4               // Packets handed to the driver awaiting their send callback
+#define ESPNOW_SOURCE_TIMEOUT_MS    1000            // Silence after which a transmitter's slot is freed
+#define ESPNOW_FRAME_SAMPLES        48              // Samples per 1 ms frame
+#define ESPNOW_FRAME_LEN            (ESPNOW_FRAME_SAMPLES * AUDIO_CHANNELS * sizeof(audio_sample_t))
 
 #define IS_BROADCAST_ADDR(addr) (memcmp(addr, broadcast_mac, ESP_NOW_ETH_ALEN) == 0)
 
@@ -23,12 +36,12 @@ typedef enum {
 typedef struct {
     uint8_t mac_addr[ESP_NOW_ETH_ALEN];
     esp_now_send_status_t status;
+    int64_t time;                         //When the driver called back, in us.
 } espnow_event_send_cb_t;
 
 typedef struct {
     uint8_t mac_addr[ESP_NOW_ETH_ALEN];
-    uint8_t *data;
-    int data_len;
+    packet_slot_t *slot;                  //Received frame, returned to the pool by the ESPNOW task.
 } espnow_event_recv_cb_t;
 
 typedef union {
@@ -48,25 +61,54 @@ enum {
     ESPNOW_DATA_MAX
 };
 
-enum {
-    ESPNOW_RBUF_INACTIVE,
-    ESPNOW_RBUF_ACTIVE,
-    ESPNOW_RBUF_ERROR
-};
-
-/* User defined field of ESPNOW data in this example. */
+/* Stream the receiver is configured for, taken from the packet headers. */
+typedef struct {
+    uint8_t codec;
+    uint8_t format;
+    uint8_t channels;
+    uint32_t sample_rate;
+    uint16_t frame_len;
+} espnow_stream_format_t;
+
+typedef void (*espnow_format_cb_t)(const espnow_stream_format_t* format);
+
+/*
+ * One transmitter heard by the receiver, keyed by its MAC address. Every
+ * source has its own sequence space, jitter buffer, FEC groups and stats,
+ * and plays out into its own mixer input.
+ */
 typedef struct {
-    uint32_t seq_num;                     //Sequence number of ESPNOW data.
-    uint16_t crc;                         //CRC16 value of ESPNOW data.
-    uint8_t payload[0];                   //Real payload of ESPNOW data.
-} __attribute__((packed)) espnow_data_t;
+    bool active;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    int64_t last_heard;
+
+    jitter_buffer_t jitter;
+    fec_decoder_t fec_dec;
+    espnow_stream_format_t stream;
+    bool stream_valid;
+    uint64_t next_timestamp;
+    bool timestamp_valid;
+
+    espnow_feedback_t feedback;           //Counts since the last report.
+    uint32_t feedback_newest_seq;
+    bool feedback_started;
+    int64_t feedback_sent;
+    jitter_buffer_stats_t feedback_jitter;
+
+    uint32_t received;                    //Since the last debug print.
+    uint32_t missed;
+} espnow_source_t;
 
 /* Parameters of sending ESPNOW data. */
 typedef struct {
     uint8_t state;                        //Indicate that if has received broadcast ESPNOW data or not.
-    bool resend_scheduled;
+    uint8_t copies_scheduled;             //Extra copies of buffer still to send.
+    bool parity_scheduled;
+    uint8_t frames;                       //1 ms frames per packet, see espnow_set_packet_ms.
     int len;                              //Length of ESPNOW data to be sent, unit: byte.
     uint8_t *buffer;                      //Buffer pointing to ESPNOW data.
+    int parity_len;
+    uint8_t *parity_buffer;               //Parity packet, FEC_PARITY_HEADER longer than buffer at most.
     uint8_t dest_mac[ESP_NOW_ETH_ALEN];   //MAC address of destination device.
 } espnow_send_param_t;
 
@@ -89,9 +131,33 @@ typedef struct {
 
     uint32_t missed_audio_cb;
 
-    int64_t packet_sent;
+    uint32_t pool_in_use;
+    uint32_t pool_peak;
+
+    uint32_t fec_recovered;
+
+    uint32_t format_changes;
+    uint32_t timestamp_jumps;             //Played frames not following on from the previous one.
+
+    uint32_t usb_cb_us_max;               //Longest USB audio callback.
+    uint32_t usb_cb_cycles_max;           //Longest USB audio callback in CPU cycles.
+    uint32_t i2s_us_max;                  //Longest I2S frame, excluding the blocking write.
+    int32_t usb_drift_ppm;                //Clock drift the USB pacer or the sinks' resamplers correct for.
+    int32_t i2s_drift_ppm;
+
     uint32_t packet_accum;
     uint32_t packet_count; 
+    uint32_t tx_failed;                   //Send callbacks reporting failure.
+    uint32_t tx_dropped;                  //Packets the driver had no room for.
+    latency_hist_t tx_latency;            //Send to send callback.
+
+    uint32_t feedback_count;              //Feedback reports sent or received.
+
+    uint32_t sources_rejected;            //Packets from a transmitter with no free source slot.
+    uint32_t rate_mismatch;               //Packets not mixed, their sample rate differs from the mix.
+
+    uint32_t channel_moves;               //Channel migrations, and hops while looking for the transmitter.
+
 } espnow_debug_t;
 
 extern xQueueHandle espnow_queue;
@@ -100,15 +166,41 @@ extern espnow_debug_t debug;
 
 esp_err_t espnow_init(bool receiver);
 void espnow_deinit(espnow_send_param_t* send_param);
-void espnow_set_rbuf(RingbufHandle_t rbuf, size_t len);
-void espnow_set_rbuf_state(uint8_t state);
+void espnow_set_rbuf(ringbuf_bcast_t* rbuf);
+void espnow_set_format_cb(espnow_format_cb_t cb);
+void espnow_set_source_gain(int source, int32_t gain);
 void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status);
 void espnow_recv_cb(const uint8_t *mac_addr, const uint8_t *data, int len);
 espnow_data_t* espnow_data_parse(uint8_t* data, uint16_t data_len, uint8_t* state, uint32_t* seq, int* magic);
+espnow_source_t* espnow_source_get(const uint8_t* mac, int64_t now);
+void espnow_source_expire(int64_t now);
+bool espnow_source_primary(const espnow_source_t* src);
+void espnow_stream_update(espnow_source_t* src, espnow_data_t* data);
 void espnow_data_prepare(espnow_send_param_t* param);
+void espnow_feedback_count(espnow_source_t* src, const espnow_data_t* data);
+void espnow_feedback_send(espnow_source_t* src);
+void espnow_feedback_recv(const espnow_feedback_t* report);
+void espnow_channel_announce();
+void espnow_channel_update();
+void espnow_channel_move(uint8_t channel);
+void espnow_channel_tick();
+void espnow_rate_set(rate_t rate);
+void espnow_housekeeping();
+uint8_t espnow_packet_parts(uint8_t ms, uint8_t codec);
+esp_err_t espnow_set_packet_ms(uint8_t ms);
+void espnow_print_packet_model();
 void espnow_task();
+void espnow_tx_task();
+void espnow_tx_complete(const espnow_event_send_cb_t* send_cb);
 void espnow_tick();
+void espnow_fec_recover(espnow_source_t* src, espnow_data_t* data, uint16_t len);
+size_t espnow_decode(espnow_data_t* data, size_t len, const void** samples);
+
+void espnow_playout(espnow_source_t* src);
+void espnow_mix();
+
 void espnow_send();
+void espnow_send_buffer(uint8_t* buffer, int len);
 void espnow_print_debug();
 
 #ifdef __cplusplus
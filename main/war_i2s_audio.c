@@ -1,24 +1,32 @@
 #include "war_i2s_audio.h"
 #include "driver/i2s.h"
-#include "freertos/ringbuf.h"
 #include "war_espnow.h"
+#include "asrc.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "math.h"
+#include <string.h>
 
-static RingbufHandle_t rbuf;
+static ringbuf_bcast_t *rbuf;
+static int rbuf_reader = -1;
+static asrc_t asrc;
+
+// Ring fill the resampler steers to, also the cushion refilled after an underrun
+#define I2S_FILL_FRAMES (48 * 2 * 4)
 
 #define SINE_SAMPLES    109
-int16_t sine_buffer[SINE_SAMPLES];
-uint16_t sine_index = 0;
+static int16_t sine_buffer[SINE_SAMPLES];
+static uint16_t sine_index = 0;
 
-void war_i2s_audio_init()
+void war_i2s_audio_init(ringbuf_bcast_t *audio_rbuf)
 {
     //I2S Periph Config
     i2s_config_t i2s_num0_config = {
         .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_TX),
         .sample_rate = 48000,
-        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .bits_per_sample = AUDIO_BYTES_PER_SAMPLE == 4 ? I2S_BITS_PER_SAMPLE_32BIT : I2S_BITS_PER_SAMPLE_16BIT,
+        // Mono: the S2 sends each sample on both slots, no widening in software
+        .channel_format = AUDIO_CHANNELS == 2 ? I2S_CHANNEL_FMT_RIGHT_LEFT : I2S_CHANNEL_FMT_ONLY_LEFT,
         .communication_format = I2S_COMM_FORMAT_STAND_I2S,
         .intr_alloc_flags = 1,
         .dma_buf_count = 4,
@@ -51,36 +59,67 @@ void war_i2s_audio_init()
     }
 
     //Ringbuffer
-    size_t len = 48 * 10 * sizeof(int16_t);
-    rbuf = xRingbufferCreate(len, RINGBUF_TYPE_BYTEBUF);
-    espnow_set_rbuf(rbuf, len);
-    espnow_set_rbuf_state(ESPNOW_RBUF_ACTIVE);
+    rbuf_reader = ringbuf_bcast_add_reader(audio_rbuf);
+    if (rbuf_reader < 0) {
+        ESP_LOGE("I2S", "Failed to add ringbuffer reader");
+        return;
+    }
+    rbuf = audio_rbuf;
+    ringbuf_bcast_set_active(rbuf, rbuf_reader, true);
+    asrc_init(&asrc, I2S_FILL_FRAMES);
 
     xTaskCreatePinnedToCore(war_i2s_audio_task, "WAR I2S Audio", 2048, NULL, 4,
         NULL, 1);
 }
 
-void war_i2s_audio_task(void *pvParam)
+void war_i2s_audio_set_format(const espnow_stream_format_t *format)
+{
+    // Driver not installed yet, it starts at 48 kHz
+    if (rbuf == NULL) {
+        return;
+    }
+    esp_err_t err = i2s_set_sample_rates(I2S_NUM_0, format->sample_rate);
+    ESP_ERROR_CHECK_WITHOUT_ABORT(err);
+}
+
+AUDIO_HOT void war_i2s_audio_task(void *pvParam)
 {
-    const bool sine_test = true;
-    size_t bytes_rcvd;
+    const size_t frame_len = 48 * 2;
+    const size_t threshold = I2S_FILL_FRAMES * AUDIO_CHANNELS;
+    bool filling = true;
     size_t bytes_written;
-    int16_t* i2s_buffer = malloc(48 * 2 * sizeof(int16_t) * 2);
+    audio_sample_t* buf = malloc(frame_len * AUDIO_CHANNELS * sizeof(audio_sample_t));
+    audio_sample_t* in = malloc(ASRC_MAX_IN * AUDIO_CHANNELS * sizeof(audio_sample_t));
     ESP_LOGI("I2S", "Audio Task Started");
     for (;;) {
-        int16_t* buf = xRingbufferReceiveUpTo(rbuf, &bytes_rcvd, portMAX_DELAY,
-            48 * 2 * sizeof(int16_t));
-        if (buf != NULL) {
-            for (int i = 0; i < bytes_rcvd/sizeof(int16_t); i++) {
-                i2s_buffer[i*2] = buf[i]; 
-                i2s_buffer[i*2+1] = buf[i]; 
+        // i2s_write blocks on the DMA buffers, which paces this loop, and
+        // the resampler takes what the transmitter's clock needs to fill it
+        int64_t start = esp_timer_get_time();
+        size_t want = asrc_input_frames(&asrc, frame_len);
+        bool got = false;
+        if (filling) {
+            filling = ringbuf_bcast_size(rbuf, rbuf_reader) < threshold;
+        } else {
+            got = ringbuf_bcast_read_frames(rbuf, rbuf_reader, in, want);
+            filling = !got;
+            if (got) {
+                asrc_steer(&asrc, ringbuf_bcast_size(rbuf, rbuf_reader) / AUDIO_CHANNELS, frame_len);
             }
-            esp_err_t err = i2s_write(I2S_NUM_0, i2s_buffer, bytes_rcvd*sizeof(int16_t), &bytes_written, portMAX_DELAY);
-            ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-            vRingbufferReturnItem(rbuf, buf);
-         } else {
-            ESP_LOGI("I2S", "Received Audio Data");
         }
+        if (!got) {
+            memset(in, 0, want * AUDIO_CHANNELS * sizeof(audio_sample_t));
+        }
+        asrc_process(&asrc, in, buf, frame_len);
+        debug.i2s_drift_ppm = asrc_ppm(&asrc);
+
+        uint32_t elapsed = esp_timer_get_time() - start;
+        if (elapsed > debug.i2s_us_max) {
+            debug.i2s_us_max = elapsed;
+        }
+
+        esp_err_t err = i2s_write(I2S_NUM_0, buf, frame_len * AUDIO_CHANNELS * sizeof(audio_sample_t), &bytes_written, portMAX_DELAY);
+        ESP_ERROR_CHECK_WITHOUT_ABORT(err);
     }
+
     vTaskDelete(NULL);
-}
\ No newline at end of file
+}
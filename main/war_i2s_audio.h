@@ -2,8 +2,11 @@
 #define __WAR_I2S_AUDIO_H__
 
 #include "freertos/FreeRTOS.h"
+#include "ringbuf_bcast.h"
+#include "war_espnow.h"
 
-void war_i2s_audio_init();
+void war_i2s_audio_init(ringbuf_bcast_t *audio_rbuf);
+void war_i2s_audio_set_format(const espnow_stream_format_t *format);
 void war_i2s_audio_task(void *pvParam);
 
 #endif // __WAR_I2S_AUDIO_H__
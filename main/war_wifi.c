@@ -1,8 +1,27 @@
 #include "war_wifi.h"
+#include "war_config.h"
 #include "esp_netif.h"
 #include "esp_now.h"
 #include "esp_private/wifi.h"
 
+#define WAR_WIFI_PROBE_DWELL_MS 20
+#define WAR_WIFI_PROBE_RECORDS  16
+
+static const wifi_phy_rate_t war_wifi_rates[RATE_COUNT] = {
+    [RATE_6M] = WIFI_PHY_RATE_6M,
+    [RATE_9M] = WIFI_PHY_RATE_9M,
+    [RATE_12M] = WIFI_PHY_RATE_12M,
+    [RATE_18M] = WIFI_PHY_RATE_18M,
+    [RATE_24M] = WIFI_PHY_RATE_24M,
+    [RATE_36M] = WIFI_PHY_RATE_36M,
+    [RATE_48M] = WIFI_PHY_RATE_48M,
+    [RATE_54M] = WIFI_PHY_RATE_54M,
+};
+
+// Smoothed, in 1/16 dBm, updated from the WiFi task
+static volatile int32_t link_rssi;
+static volatile int32_t link_noise;
+
 void war_wifi_init() {
     ESP_ERROR_CHECK( esp_netif_init() );
     ESP_ERROR_CHECK( esp_event_loop_create_default() );
@@ -10,7 +29,81 @@ void war_wifi_init() {
     ESP_ERROR_CHECK( esp_wifi_init(&cfg) );
     ESP_ERROR_CHECK( esp_wifi_set_storage(WIFI_STORAGE_RAM) );
     ESP_ERROR_CHECK( esp_wifi_set_mode(WIFI_MODE_STA) );
-    ESP_ERROR_CHECK( esp_wifi_config_espnow_rate(WIFI_IF_STA, WIFI_PHY_RATE_36M) );
+    ESP_ERROR_CHECK( war_wifi_set_rate(ESPNOW_RATE) );
     ESP_ERROR_CHECK( esp_wifi_start() );
-    ESP_ERROR_CHECK( esp_wifi_set_channel(8, WIFI_SECOND_CHAN_NONE) );
-}
\ No newline at end of file
+    ESP_ERROR_CHECK( esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE) );
+}
+
+esp_err_t war_wifi_set_rate(rate_t rate) {
+    return esp_wifi_config_espnow_rate(WIFI_IF_STA, war_wifi_rates[rate]);
+}
+
+esp_err_t war_wifi_set_channel(uint8_t channel) {
+    // Peers are added on channel 0, which follows the radio
+    return esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+}
+
+esp_err_t war_wifi_probe(uint8_t channel, channel_probe_t* probe) {
+    uint8_t current;
+    wifi_second_chan_t second;
+    ESP_ERROR_CHECK( esp_wifi_get_channel(&current, &second) );
+
+    wifi_scan_config_t cfg = {
+        .channel = channel,
+        .show_hidden = true,
+        .scan_type = WIFI_SCAN_TYPE_PASSIVE,
+        .scan_time.passive = WAR_WIFI_PROBE_DWELL_MS,
+    };
+    esp_err_t err = esp_wifi_scan_start(&cfg, true);
+
+    probe->networks = 0;
+    probe->strongest = 0;
+    if (err == ESP_OK) {
+        uint16_t count = 0;
+        esp_wifi_scan_get_ap_num(&count);
+        probe->networks = count < UINT8_MAX ? count : UINT8_MAX;
+
+        wifi_ap_record_t records[WAR_WIFI_PROBE_RECORDS];
+        uint16_t n = WAR_WIFI_PROBE_RECORDS;
+        // Also frees the driver's list when there are more than fit
+        if (esp_wifi_scan_get_ap_records(&n, records) == ESP_OK) {
+            for (int i = 0; i < n; i++) {
+                if (probe->strongest == 0 || records[i].rssi > probe->strongest)
+                    probe->strongest = records[i].rssi;
+            }
+        }
+    }
+
+    esp_wifi_set_channel(current, WIFI_SECOND_CHAN_NONE);
+    return err;
+}
+
+// ESP-NOW frames are vendor specific action frames with Espressif's OUI
+static void war_wifi_monitor_cb(void* buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    const uint8_t* frame = pkt->payload;
+
+    link_noise += (pkt->rx_ctrl.noise_floor * 16 - link_noise) / 16;
+    if (pkt->rx_ctrl.sig_len < 28 || frame[0] != 0xd0 || frame[24] != 0x7f ||
+        frame[25] != 0x18 || frame[26] != 0xfe || frame[27] != 0x34)
+        return;
+    link_rssi += (pkt->rx_ctrl.rssi * 16 - link_rssi) / 16;
+}
+
+esp_err_t war_wifi_monitor_start() {
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT,
+    };
+    link_rssi = link_noise = 0;
+    esp_err_t err = esp_wifi_set_promiscuous_filter(&filter);
+    if (err == ESP_OK)
+        err = esp_wifi_set_promiscuous_rx_cb(war_wifi_monitor_cb);
+    if (err == ESP_OK)
+        err = esp_wifi_set_promiscuous(true);
+    return err;
+}
+
+void war_wifi_link_quality(int8_t* rssi, int8_t* noise) {
+    *rssi = link_rssi / 16;
+    *noise = link_noise / 16;
+}
@@ -3,7 +3,22 @@
 
 #include <stdint.h>
 #include "esp_wifi.h"
+#include "channel.h"
+#include "rate_ctrl.h"
 
 void war_wifi_init();
 
+// PHY rate ESP-NOW frames go out at
+esp_err_t war_wifi_set_rate(rate_t rate);
+
+// Moves the radio, and with it every ESP-NOW peer, to channel
+esp_err_t war_wifi_set_channel(uint8_t channel);
+
+// Passive scan of one channel, returns to the current channel after
+esp_err_t war_wifi_probe(uint8_t channel, channel_probe_t* probe);
+
+// Watches incoming ESP-NOW frames for their RSSI and the noise floor
+esp_err_t war_wifi_monitor_start();
+void war_wifi_link_quality(int8_t* rssi, int8_t* noise);
+
 #endif // __WIFI_H__
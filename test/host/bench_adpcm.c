@@ -0,0 +1,87 @@
+// IMA ADPCM quality and speed: SNR of the decoded signal and encode/decode
+// throughput on 20 s test signals in 96-sample (2 ms) blocks.
+
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "adpcm.h"
+
+#define RATE                    48000
+#define SECONDS                 20
+#define SAMPLES                 (RATE * SECONDS)
+#define BLOCK                   96
+
+static int16_t in[SAMPLES], out[SAMPLES];
+static uint8_t coded[SAMPLES / BLOCK * ADPCM_ENCODED_LEN(BLOCK)];
+
+static void make_sine(void)
+{
+    for (int i = 0; i < SAMPLES; i++)
+        in[i] = lrint(0.5 * 32767 * sin(2 * M_PI * 1000.0 * i / RATE));
+}
+
+static void make_mix(void)
+{
+    uint32_t seed = 7;
+    for (int i = 0; i < SAMPLES; i++) {
+        double t = (double)i / RATE;
+        double x = 0.25 * sin(2 * M_PI * 220 * t) + 0.15 * sin(2 * M_PI * 1330 * t)
+                 + 0.1 * sin(2 * M_PI * 4100 * t) + 0.02 * ((double)host_rand(&seed) / 4294967296.0 - 0.5);
+        in[i] = lrint(x * 32767);
+    }
+}
+
+// Logarithmic sweep from 20 Hz to 20 kHz
+static void make_sweep(void)
+{
+    double k = log(20000.0 / 20.0) / SECONDS;
+    for (int i = 0; i < SAMPLES; i++) {
+        double t = (double)i / RATE;
+        in[i] = lrint(0.5 * 32767 * sin(2 * M_PI * 20.0 * (exp(k * t) - 1) / k));
+    }
+}
+
+static void run(const char *name, void (*make)(void))
+{
+    make();
+
+    size_t coded_len = 0;
+    double enc_best = 1e9, dec_best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        adpcm_state_t state;
+        adpcm_init(&state);
+        coded_len = 0;
+        double start = host_seconds();
+        for (int b = 0; b < SAMPLES; b += BLOCK)
+            coded_len += adpcm_encode(&state, &in[b], BLOCK, &coded[coded_len]);
+        double enc = host_seconds() - start;
+
+        size_t decoded = 0;
+        start = host_seconds();
+        for (size_t pos = 0; pos < coded_len; pos += ADPCM_ENCODED_LEN(BLOCK))
+            decoded += adpcm_decode(&coded[pos], ADPCM_ENCODED_LEN(BLOCK), &out[decoded]);
+        double dec = host_seconds() - start;
+        CHECK(decoded == SAMPLES);
+        enc_best = enc < enc_best ? enc : enc_best;
+        dec_best = dec < dec_best ? dec : dec_best;
+    }
+
+    double sig = 0, err = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        double e = (double)in[i] - out[i];
+        sig += (double)in[i] * in[i];
+        err += e * e;
+    }
+    printf("%-8s  %6.1f  %12.1f  %12.1f  %6zu\n", name, 10 * log10(sig / err),
+           SAMPLES / enc_best * 1e-6, SAMPLES / dec_best * 1e-6, coded_len / (SAMPLES / BLOCK));
+}
+
+int main(void)
+{
+    printf("%d s at %d Hz, %d-sample blocks, best of 3\n", SECONDS, RATE, BLOCK);
+    printf("signal    SNR dB  enc Msamp/s  dec Msamp/s  bytes/block\n");
+    run("sine", make_sine);
+    run("mix", make_mix);
+    run("sweep", make_sweep);
+    return host_result("bench_adpcm");
+}
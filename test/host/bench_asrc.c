@@ -0,0 +1,154 @@
+// ASRC quality, cost and long-run fill. The SNR of a 997 Hz tone
+// resampled at fixed corrections against the exact resampled tone, the
+// cycles per output frame, and 1 h of clock drift: 2 ms packets arriving
+// 0 to jitter ms late at the transmitter's clock, 48 frames taken every
+// 1 ms of the sink's clock with the sinks' refill after an underrun, fill
+// and correction reported after the first minute.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "asrc.h"
+
+#define OUT_FRAMES              48
+#define TARGET_FILL             384
+#define RING_FRAMES             4096
+#define SETTLE_S                60
+
+#if AUDIO_BYTES_PER_SAMPLE == 4
+#define FULL_SCALE              2147483647.0
+#else
+#define FULL_SCALE              32767.0
+#endif
+
+static asrc_t asrc;
+static audio_sample_t in[ASRC_MAX_IN * AUDIO_CHANNELS], out[OUT_FRAMES * AUDIO_CHANNELS];
+
+static double quality(int ppm)
+{
+    const double w = 2 * M_PI * 997.0 / 48000;
+    asrc_init(&asrc, 0);
+    asrc.delta = (int32_t)llround(ppm * 4294.967296);
+    double step = 1 + asrc.delta / 4294967296.0, sig = 0, err = 0;
+    long produced = 0, consumed = 0;
+    for (int call = 0; call < 20000; call++) {
+        size_t n = asrc_input_frames(&asrc, OUT_FRAMES);
+        for (size_t i = 0; i < n; i++, consumed++)
+            for (int c = 0; c < AUDIO_CHANNELS; c++)
+                in[i * AUDIO_CHANNELS + c] = lrint(0.5 * FULL_SCALE * sin(w * consumed));
+        asrc_process(&asrc, in, out, OUT_FRAMES);
+        for (int k = 0; k < OUT_FRAMES; k++, produced++) {
+            if (produced < 1000)                // Filter filling up
+                continue;
+            double ref = 0.5 * FULL_SCALE * sin(w * (produced * step - ASRC_TAPS / 2));
+            double e = out[k * AUDIO_CHANNELS] - ref;
+            sig += ref * ref;
+            err += e * e;
+        }
+    }
+    return 10 * log10(sig / err);
+}
+
+static double cycles_per_frame(void)
+{
+    const int calls = 200000;
+    uint32_t seed = 1;
+    for (int i = 0; i < ASRC_MAX_IN * AUDIO_CHANNELS; i++)
+        in[i] = host_rand(&seed);
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        asrc_init(&asrc, 0);
+        asrc.delta = 200 * 4295;
+        uint64_t start = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            asrc_input_frames(&asrc, OUT_FRAMES);
+            asrc_process(&asrc, in, out, OUT_FRAMES);
+        }
+        double cycles = (double)(host_cycles() - start) / calls / OUT_FRAMES;
+        best = cycles < best ? cycles : best;
+    }
+    host_sink = out[0];
+    return best;
+}
+
+static void drift(int tx_ppm, int rx_ppm, double seconds, double jitter_ms)
+{
+    double tx_period = 0.002 / (1 + tx_ppm * 1e-6), rx_period = 0.001 / (1 + rx_ppm * 1e-6);
+    double next_tx = 0, next_rx = 0, pending[64], ppm_sum = 0;
+    long fill = 0, min_fill = RING_FRAMES, max_fill = 0, underruns = 0, overruns = 0, polls = 0;
+    int32_t last_delta = 0, max_step = 0;
+    int queued = 0;
+    bool filling = true;
+    uint32_t seed = 7;
+
+    asrc_init(&asrc, TARGET_FILL);
+    while (next_rx < seconds) {
+        while (next_tx <= next_rx) {
+            double arrive = next_tx + host_rand(&seed) / 4294967296.0 * jitter_ms * 1e-3;
+            if (queued && arrive < pending[queued - 1])
+                arrive = pending[queued - 1];
+            pending[queued++] = arrive;
+            next_tx += tx_period;
+        }
+        while (queued && pending[0] <= next_rx) {
+            fill += 96;
+            if (fill > RING_FRAMES) {
+                overruns += fill - RING_FRAMES;
+                fill = RING_FRAMES;
+            }
+            memmove(pending, pending + 1, --queued * sizeof(pending[0]));
+        }
+
+        // Like the sinks: conceal until the cushion is back, then read
+        bool settled = next_rx >= SETTLE_S;
+        size_t n = asrc_input_frames(&asrc, OUT_FRAMES);
+        if (filling) {
+            filling = fill < TARGET_FILL;
+        } else if ((long)n > fill) {
+            underruns += settled;
+            fill = 0;
+            filling = true;
+        } else {
+            fill -= n;
+            asrc_process(&asrc, in, out, OUT_FRAMES);
+            asrc_steer(&asrc, fill, OUT_FRAMES);
+        }
+
+        if (settled) {
+            int32_t step = abs(asrc.delta - last_delta);
+            max_step = step > max_step ? step : max_step;
+            min_fill = fill < min_fill ? fill : min_fill;
+            max_fill = fill > max_fill ? fill : max_fill;
+            ppm_sum += asrc_ppm(&asrc);
+            polls++;
+        }
+        last_delta = asrc.delta;
+        next_rx += rx_period;
+    }
+    printf("%+7d  %+6d  %3.0f ms  %4ld..%-4ld  %+10.1f  %8.1f  %9ld  %8ld\n", tx_ppm, rx_ppm, jitter_ms,
+           min_fill, max_fill, ppm_sum / polls, max_step / 4294.967296, underruns, overruns);
+}
+
+int main(void)
+{
+    printf("%d channel(s), %d bytes per sample\n", AUDIO_CHANNELS, AUDIO_BYTES_PER_SAMPLE);
+    const int ppms[] = { 0, 200, -200, 1000 };
+    for (size_t i = 0; i < sizeof(ppms) / sizeof(ppms[0]); i++)
+        printf("997 Hz at %+5d ppm: SNR %.1f dB\n", ppms[i], quality(ppms[i]));
+    printf("%.1f %s per output frame, best of 3\n", cycles_per_frame(), HOST_CYCLE_UNIT);
+
+    printf("\n1 h per case, after the first %d s\n", SETTLE_S);
+    printf("tx ppm  rx ppm  jitter  fill        correction  max step  underruns  overruns\n");
+    const struct {
+        int tx, rx;
+        double jitter_ms;
+    } cases[] = {
+        { 0, 0, 4 }, { 200, 0, 4 }, { -200, 0, 4 }, { 100, -100, 4 },
+        { 0, 200, 4 }, { -100, 100, 4 }, { 200, -200, 10 },
+    };
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+        drift(cases[c].tx, cases[c].rx, 3600, cases[c].jitter_ms);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Cost of the volume gain on a 1 ms block: unity, where the samples pass
+// through untouched, a steady attenuation, and a ramp running through the
+// whole block. Each call first copies a fresh block in, so the unity cost
+// is mostly that copy. Also the error of gain_from_db against the exact
+// dB curve and the largest step of a 0 to -20 dB ramp.
+
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "gain.h"
+
+#define FRAMES                  48
+#define ITERATIONS              1000000
+
+#if AUDIO_BYTES_PER_SAMPLE == 4
+#define FULL_SCALE              2147483647.0
+#else
+#define FULL_SCALE              32767.0
+#endif
+
+enum {
+    MODE_UNITY,
+    MODE_STEADY,
+    MODE_RAMP,
+};
+
+static gain_t gain;
+static audio_sample_t in[FRAMES * AUDIO_CHANNELS], buf[FRAMES * AUDIO_CHANNELS];
+
+static double bench(int mode)
+{
+    int32_t levels[2] = { gain_from_db(-12 * 256), gain_from_db(-6 * 256) };
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        gain_init(&gain);
+        if (mode == MODE_STEADY) {
+            for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+                gain_set(&gain, ch, levels[0]);
+            for (int i = 0; i < GAIN_RAMP_FRAMES / FRAMES + 1; i++)
+                gain_apply(&gain, buf, FRAMES);
+        }
+        int64_t sum = 0;
+        uint64_t start = host_cycles();
+        for (int it = 0; it < ITERATIONS; it++) {
+            memcpy(buf, in, sizeof(buf));
+            // A new level every block keeps the ramp running throughout
+            if (mode == MODE_RAMP)
+                gain_set(&gain, 0, levels[it & 1]);
+            gain_apply(&gain, buf, FRAMES);
+            sum += buf[it % (FRAMES * AUDIO_CHANNELS)];
+        }
+        double cycles = (double)(host_cycles() - start) / ITERATIONS;
+        host_sink = sum;
+        best = cycles < best ? cycles : best;
+    }
+    return best;
+}
+
+static void accuracy(void)
+{
+    double worst = 0, worst_db = 0;
+    for (int v = GAIN_DB_MIN * 256 + 1; v <= 0; v++) {
+        double exact = v / 256.0;
+        double got = 20 * log10(gain_from_db(v) / (double)GAIN_UNITY);
+        if (fabs(got - exact) > worst) {
+            worst = fabs(got - exact);
+            worst_db = exact;
+        }
+    }
+    printf("gain_from_db, 0..%d dB in 1/256 dB steps: worst error %.4f dB at %.2f dB\n",
+           GAIN_DB_MIN, worst, worst_db);
+}
+
+static void ramp(void)
+{
+    int32_t target = gain_from_db(-20 * 256);
+    gain_init(&gain);
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        gain_set(&gain, ch, target);
+
+    // Full scale DC shows the gain frame by frame
+    double prev = 1, max_step = 0;
+    for (int call = 0; call < GAIN_RAMP_FRAMES / FRAMES + 2; call++) {
+        for (int i = 0; i < FRAMES * AUDIO_CHANNELS; i++)
+            buf[i] = (audio_sample_t)FULL_SCALE;
+        gain_apply(&gain, buf, FRAMES);
+        for (int i = 0; i < FRAMES; i++) {
+            double v = buf[i * AUDIO_CHANNELS] / FULL_SCALE;
+            max_step = prev - v > max_step ? prev - v : max_step;
+            prev = v;
+        }
+    }
+    printf("0 to -20 dB over %d frames: largest step %.5f of full scale (%.1f dB), settled at %.6f, target %.6f\n",
+           GAIN_RAMP_FRAMES, max_step, 20 * log10(max_step), prev, target / (double)GAIN_UNITY);
+}
+
+int main(void)
+{
+    for (int i = 0; i < FRAMES * AUDIO_CHANNELS; i++)
+        in[i] = (audio_sample_t)((i * 997) % 20000 - 10000) * (1 << AUDIO_SAMPLE_SHIFT);
+
+    printf("%d channel(s), %d bytes per sample, best of 3 x %d blocks of %d frames\n", AUDIO_CHANNELS,
+           AUDIO_BYTES_PER_SAMPLE, ITERATIONS, FRAMES);
+    printf("unity:          %6.1f %s per block\n", bench(MODE_UNITY), HOST_CYCLE_UNIT);
+    printf("steady -12 dB:  %6.1f %s per block\n", bench(MODE_STEADY), HOST_CYCLE_UNIT);
+    printf("ramping:        %6.1f %s per block\n", bench(MODE_RAMP), HOST_CYCLE_UNIT);
+    accuracy();
+    ramp();
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Cost of mixing 1 ms per active source: every source queues a 48-frame
+// block at half gain and one block is mixed, FIFO writes included. Also the
+// lone source at unity gain, which is copied through.
+
+#include "host_test.h"
+#include "mixer.h"
+
+#define ITERATIONS              200000
+
+static mixer_t mixer;
+static audio_sample_t in[MIXER_FRAME * AUDIO_CHANNELS], out[MIXER_FRAME * AUDIO_CHANNELS];
+
+static double bench(int sources, int32_t gain)
+{
+    double best = 1e9;
+    for (int rep = 0; rep < 5; rep++) {
+        mixer_init(&mixer);
+        for (int s = 0; s < sources; s++) {
+            mixer_set_active(&mixer, s, true);
+            mixer_set_gain(&mixer, s, gain);
+        }
+        int64_t sum = 0;
+        double start = host_seconds();
+        for (int it = 0; it < ITERATIONS; it++) {
+            for (int s = 0; s < sources; s++)
+                mixer_write(&mixer, s, in, MIXER_FRAME * AUDIO_CHANNELS);
+            mixer_mix(&mixer, out);
+            sum += out[it % MIXER_FRAME];
+        }
+        double ns = (host_seconds() - start) / ITERATIONS * 1e9;
+        host_sink = sum;
+        best = ns < best ? ns : best;
+    }
+    return best;
+}
+
+int main(void)
+{
+    for (int i = 0; i < MIXER_FRAME * AUDIO_CHANNELS; i++)
+        in[i] = (audio_sample_t)((i * 997) % 20000 - 10000) * (1 << AUDIO_SAMPLE_SHIFT);
+
+    printf("%d channel(s), %d bytes per sample, best of 5 x %d blocks\n", AUDIO_CHANNELS,
+           AUDIO_BYTES_PER_SAMPLE, ITERATIONS);
+    printf("sources  ns per ms  ns per source\n");
+    for (int sources = 1; sources <= MIXER_MAX_SOURCES; sources++) {
+        double ns = bench(sources, MIXER_UNITY / 2);
+        printf("%7d  %9.0f  %13.0f\n", sources, ns, ns / sources);
+    }
+    printf("1 source at unity (copy): %.0f ns per ms\n", bench(1, MIXER_UNITY));
+    return 0;
+}
@@ -0,0 +1,84 @@
+// packet_model table for the transmitter settings: packets/s, bytes on air,
+// header overhead and added latency per packet duration, codec, sample
+// format and protection, with the sizes war_espnow.c uses.
+
+#include "host_test.h"
+#include "esp_now.h"
+#include "packet_model.h"
+#include "espnow_proto.h"
+#include "adpcm.h"
+#include "lossless.h"
+#include "fec_xor.h"
+
+#define FRAME_SAMPLES           48              // Per 1 ms
+#define MAX_MS                  4
+#define JITTER_DEPTH            3
+
+// Parts a packet duration is split into, as espnow_packet_parts()
+static uint32_t parts_of(uint32_t ms, int codec, uint32_t sample_bytes, bool fec)
+{
+    uint32_t frames = ms * FRAME_SAMPLES;
+    uint32_t room = ESP_NOW_MAX_DATA_LEN - sizeof(espnow_data_t) - (fec ? FEC_PARITY_HEADER : 0);
+    if (codec == ESPNOW_CODEC_ADPCM)
+        return ADPCM_ENCODED_LEN(frames) <= room;
+    if (codec == ESPNOW_CODEC_LOSSLESS)
+        return LOSSLESS_MAX_LEN(frames) <= room;
+    for (uint32_t parts = 1; parts <= frames; parts++)
+        if (frames % parts == 0 && frames / parts * sample_bytes <= room)
+            return parts;
+    return 0;
+}
+
+int main(void)
+{
+    const struct {
+        const char *name;
+        int codec;
+        uint32_t sample_bytes;                  // Per frame, all channels
+    } formats[] = {
+        { "PCM s16 mono", ESPNOW_CODEC_PCM, 2 },
+        { "PCM s24 stereo", ESPNOW_CODEC_PCM, 8 },
+        { "ADPCM", ESPNOW_CODEC_ADPCM, 2 },
+        { "lossless", ESPNOW_CODEC_LOSSLESS, 2 },
+    };
+    const struct {
+        const char *name;
+        uint32_t fec_k, copies;
+    } protections[] = {
+        { "single", 0, 0 },
+        { "copy", 0, 1 },
+        { "FEC K=3", 3, 0 },
+        { "FEC K=4", 4, 0 },
+    };
+
+    printf("%zu-byte header, jitter depth %d (at least K), lossless at its worst case size\n",
+           sizeof(espnow_data_t), JITTER_DEPTH);
+    printf("format          protection  ms  parts  pkt/s  air bytes  header %%  latency us\n");
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (size_t p = 0; p < sizeof(protections) / sizeof(protections[0]); p++) {
+            uint32_t k = protections[p].fec_k;
+            for (uint32_t ms = 1; ms <= MAX_MS; ms *= 2) {
+                uint32_t parts = parts_of(ms, formats[f].codec, formats[f].sample_bytes, k > 0);
+                if (parts == 0) {
+                    printf("%-15s %-10s  %2u  does not fit\n", formats[f].name, protections[p].name, ms);
+                    continue;
+                }
+                uint32_t frames = ms * FRAME_SAMPLES / parts;
+                uint32_t payload = frames * formats[f].sample_bytes;
+                if (formats[f].codec == ESPNOW_CODEC_ADPCM)
+                    payload = ADPCM_ENCODED_LEN(frames);
+                else if (formats[f].codec == ESPNOW_CODEC_LOSSLESS)
+                    payload = LOSSLESS_MAX_LEN(frames);
+
+                packet_model_t m;
+                packet_model(ms, parts, sizeof(espnow_data_t), payload, k, protections[p].copies,
+                             k > JITTER_DEPTH ? k : JITTER_DEPTH, &m);
+                printf("%-15s %-10s  %2u  %5u  %5u  %9u  %7u.%u  %5u-%u\n", formats[f].name,
+                       protections[p].name, ms, parts, m.packets_per_sec, m.air_bytes,
+                       m.overhead_permille / 10, m.overhead_permille % 10, m.latency_us,
+                       m.worst_latency_us);
+            }
+        }
+    }
+    return 0;
+}
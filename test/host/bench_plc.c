@@ -0,0 +1,87 @@
+// Cost and error of plc: cycles per 1 ms block for the first concealed block
+// (pitch search included), later concealed blocks and passed-through blocks,
+// and the SNR against the original of two-harmonic tones with 2 blocks in
+// every 20 lost.
+
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "plc.h"
+
+#define BLOCK                   48              // 1 ms at 48 kHz
+#define BLOCKS                  20000
+#define RATE                    48000.0
+
+static plc_t plc;
+
+static audio_sample_t tone(double f0, uint32_t t, int c)
+{
+    double x = 0.35 * sin(2 * M_PI * f0 * t / RATE + c) + 0.15 * sin(2 * M_PI * 2 * f0 * t / RATE + 0.5 + c);
+    return (audio_sample_t)lrint(x * 32767) << AUDIO_SAMPLE_SHIFT;
+}
+
+static void fill(audio_sample_t *buf, double f0, uint32_t t)
+{
+    for (int i = 0; i < BLOCK; i++)
+        for (int c = 0; c < AUDIO_CHANNELS; c++)
+            buf[i * AUDIO_CHANNELS + c] = tone(f0, t + i, c);
+}
+
+static void run(double f0)
+{
+    audio_sample_t orig[BLOCK * AUDIO_CHANNELS], buf[BLOCK * AUDIO_CHANNELS];
+    uint64_t first = UINT64_MAX, next = UINT64_MAX, good = UINT64_MAX;
+    double sig = 0, err = 0, sig_lost = 0, err_lost = 0;
+
+    plc_init(&plc);
+    for (uint32_t b = 0; b < BLOCKS; b++) {
+        fill(orig, f0, b * BLOCK);
+        memcpy(buf, orig, sizeof(buf));
+        // Two consecutive blocks in every 20 lost
+        bool lost = b % 20 >= 10 && b % 20 < 12;
+        uint64_t start = host_cycles();
+        if (lost)
+            plc_conceal(&plc, buf, BLOCK);
+        else
+            plc_good_frame(&plc, buf, BLOCK);
+        uint64_t cycles = host_cycles() - start;
+        if (b % 20 == 10)
+            first = cycles < first ? cycles : first;
+        else if (lost)
+            next = cycles < next ? cycles : next;
+        else if (b % 20 != 12)                  // Not the crossfade block
+            good = cycles < good ? cycles : good;
+
+        if (b < 20)                             // History filling up
+            continue;
+        for (int i = 0; i < BLOCK * AUDIO_CHANNELS; i++) {
+            double s = AUDIO_SAMPLE_TO_I16(orig[i]);
+            double e = s - AUDIO_SAMPLE_TO_I16(buf[i]);
+            sig += s * s;
+            err += e * e;
+            if (lost) {
+                sig_lost += s * s;
+                err_lost += e * e;
+            }
+        }
+    }
+    host_sink = buf[0];
+    printf("%6.1f Hz  pitch %3u  %9llu  %9llu  %9llu  %8.1f  %8.1f\n", f0, plc.pitch,
+           (unsigned long long)first, (unsigned long long)next, (unsigned long long)good,
+           10 * log10(sig / err), 10 * log10(sig_lost / err_lost));
+}
+
+int main(void)
+{
+    printf("%d channel(s), %d bytes per sample, best of %d blocks, %s per 1 ms block\n",
+           AUDIO_CHANNELS, AUDIO_BYTES_PER_SAMPLE, BLOCKS, HOST_CYCLE_UNIT);
+    printf("tone      pitch      first     repeat       good  SNR dB  lost SNR dB\n");
+    // Periods that are not a whole number of frames, the last one past half
+    // the history, where the seam crossfade reaches back before the oldest
+    // frame
+    run(97.3);
+    run(213.7);
+    run(471.1);
+    run(70.3);
+    return 0;
+}
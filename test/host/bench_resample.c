@@ -0,0 +1,166 @@
+// Resampler cost and quality in both directions between 44.1 and 48 kHz:
+// cycles per output frame, passband flatness over 20 Hz-20 kHz, the SNR
+// of a 997 Hz tone, and the strongest alias (going down) or image (going
+// up) that lands below 20 kHz. Output is produced 1 ms at a time like the
+// USB sink, the first RESAMPLE_SKIP frames are the filter filling up.
+
+#include <math.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "resample.h"
+
+#define RESAMPLE_SKIP           1000
+
+#if AUDIO_BYTES_PER_SAMPLE == 4
+#define FULL_SCALE              2147483647.0
+#else
+#define FULL_SCALE              32767.0
+#endif
+
+static resample_t rs;
+static audio_sample_t in[RESAMPLE_MAX_IN * AUDIO_CHANNELS], out[RESAMPLE_MAX_FRAMES * AUDIO_CHANNELS];
+
+// One second of a tone at f Hz, amplitude a, resampled into y
+static void run(uint32_t in_rate, uint32_t out_rate, double f, double a, double* y)
+{
+    uint32_t acc = 0;
+    size_t done = 0, t = 0;
+    resample_init(&rs, in_rate, out_rate);
+    while (done < out_rate) {
+        acc += out_rate;
+        size_t n = acc / 1000;
+        acc %= 1000;
+        size_t m = resample_input_frames(&rs, n);
+        for (size_t i = 0; i < m; i++, t++)
+            for (int c = 0; c < AUDIO_CHANNELS; c++)
+                in[i * AUDIO_CHANNELS + c] = lrint(a * FULL_SCALE * sin(2 * M_PI * f * t / in_rate));
+        resample_process(&rs, in, out, n);
+        for (size_t i = 0; i < n; i++)
+            y[done + i] = out[i * AUDIO_CHANNELS] / FULL_SCALE;
+        done += n;
+    }
+}
+
+// Hann windowed amplitude at f over y[RESAMPLE_SKIP..n)
+static double level(const double* y, size_t n, double f, double rate)
+{
+    double re = 0, im = 0, sum = 0;
+    for (size_t i = RESAMPLE_SKIP; i < n; i++) {
+        double w = 0.5 - 0.5 * cos(2 * M_PI * (i - RESAMPLE_SKIP) / (n - RESAMPLE_SKIP));
+        re += w * y[i] * cos(2 * M_PI * f * i / rate);
+        im += w * y[i] * sin(2 * M_PI * f * i / rate);
+        sum += w;
+    }
+    return 2 * sqrt(re * re + im * im) / sum;
+}
+
+// Power of the best fit sine at f over everything else, THD+N
+static double snr(const double* y, size_t n, double f, double rate)
+{
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    for (size_t i = RESAMPLE_SKIP; i < n; i++) {
+        double s = sin(2 * M_PI * f * i / rate), c = cos(2 * M_PI * f * i / rate);
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += y[i] * s;
+        yc += y[i] * c;
+    }
+    double det = ss * cc - sc * sc, a = (ys * cc - yc * sc) / det, b = (yc * ss - ys * sc) / det;
+    double sig = 0, err = 0;
+    for (size_t i = RESAMPLE_SKIP; i < n; i++) {
+        double fit = a * sin(2 * M_PI * f * i / rate) + b * cos(2 * M_PI * f * i / rate);
+        sig += fit * fit;
+        err += (y[i] - fit) * (y[i] - fit);
+    }
+    return 10 * log10(sig / err);
+}
+
+static void quality(uint32_t in_rate, uint32_t out_rate)
+{
+    double* y = malloc(out_rate * sizeof(double));
+    double lo = 1e9, hi = -1e9, lo_f = 0, hi_f = 0;
+    for (double f = 20;; f *= 1.05) {
+        f = f > 20000 ? 20000 : f;              // Always end on the band edge
+        run(in_rate, out_rate, f, 0.5, y);
+        double g = 20 * log10(level(y, out_rate, f, out_rate) / 0.5);
+        if (g < lo) {
+            lo = g;
+            lo_f = f;
+        }
+        if (g > hi) {
+            hi = g;
+            hi_f = f;
+        }
+        if (f == 20000)
+            break;
+    }
+    run(in_rate, out_rate, 997, 0.5, y);
+    printf("%u -> %u Hz: passband %+.3f..%+.3f dB (at %.0f / %.0f Hz), 997 Hz at -6 dBFS SNR %.1f dB\n",
+           in_rate, out_rate, lo, hi, lo_f, hi_f, snr(y, out_rate, 997, out_rate));
+
+    // Going down, input above the output's Nyquist folds back; going up,
+    // every tone has an image mirrored about the input's Nyquist
+    double worst = -1e9, worst_f = 0, worst_at = 0;
+    for (double f = 20; f < in_rate / 2.0; f += 97) {
+        double at = in_rate > out_rate ? out_rate - f : in_rate - f;
+        if (in_rate > out_rate && f <= out_rate / 2.0)
+            continue;
+        if (at > out_rate / 2.0)
+            at = out_rate - at;
+        if (at >= 20000 || fabs(at - f) < 200)
+            continue;
+        run(in_rate, out_rate, f, 0.5, y);
+        double g = 20 * log10(level(y, out_rate, at, out_rate) / 0.5 + 1e-12);
+        if (g > worst) {
+            worst = g;
+            worst_f = f;
+            worst_at = at;
+        }
+    }
+    if (worst_f != 0)
+        printf("  strongest %s below 20 kHz: %.0f Hz tone -> %.0f Hz at %.1f dB\n",
+               in_rate > out_rate ? "alias" : "image", worst_f, worst_at, worst);
+    else
+        printf("  no %s lands below 20 kHz\n", in_rate > out_rate ? "alias" : "image");
+    free(y);
+}
+
+static void cycles(uint32_t in_rate, uint32_t out_rate)
+{
+    const int calls = 200000;
+    uint32_t seed = 1;
+    for (int i = 0; i < RESAMPLE_MAX_IN * AUDIO_CHANNELS; i++)
+        in[i] = host_rand(&seed);
+    double best = 1e9;
+    for (int rep = 0; rep < 3; rep++) {
+        resample_init(&rs, in_rate, out_rate);
+        uint32_t acc = 0;
+        size_t frames = 0;
+        uint64_t start = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            acc += out_rate;
+            size_t n = acc / 1000;
+            acc %= 1000;
+            resample_input_frames(&rs, n);
+            resample_process(&rs, in, out, n);
+            frames += n;
+        }
+        double c = (double)(host_cycles() - start) / frames;
+        best = c < best ? c : best;
+    }
+    host_sink = out[0];
+    printf("%u -> %u Hz: %.1f %s per output frame, best of 3\n", in_rate, out_rate, best, HOST_CYCLE_UNIT);
+}
+
+int main(void)
+{
+    printf("%d channel(s), %d bytes per sample\n", AUDIO_CHANNELS, AUDIO_BYTES_PER_SAMPLE);
+    resample_prepare(48000, 44100);
+    resample_prepare(44100, 48000);
+    cycles(48000, 44100);
+    cycles(44100, 48000);
+    quality(48000, 44100);
+    quality(44100, 48000);
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Throughput of ringbuf_i16 per block size: the per sample write/read
+// against the block write_buf/read_buf, one thread doing both sides.
+
+#include <string.h>
+#include "host_test.h"
+#include "ringbuf_i16.h"
+
+#define BENCH_SAMPLES           (1u << 26)
+
+static ringbuf_i16_t rbuf;
+static int16_t in[RINGBUF_I16_CAPACITY], out[RINGBUF_I16_CAPACITY];
+
+static double bench_per_sample(size_t block)
+{
+    ringbuf_i16_reset(&rbuf);
+    int64_t sum = 0;
+    double start = host_seconds();
+    for (uint32_t done = 0; done < BENCH_SAMPLES; done += block) {
+        for (size_t i = 0; i < block; i++)
+            ringbuf_i16_write(&rbuf, in[i]);
+        for (size_t i = 0; i < block; i++)
+            sum += ringbuf_i16_read(&rbuf);
+    }
+    double elapsed = host_seconds() - start;
+    host_sink = sum;
+    return BENCH_SAMPLES / elapsed;
+}
+
+static double bench_block(size_t block)
+{
+    ringbuf_i16_reset(&rbuf);
+    int64_t sum = 0;
+    double start = host_seconds();
+    for (uint32_t done = 0; done < BENCH_SAMPLES; done += block) {
+        ringbuf_i16_write_buf(&rbuf, in, block);
+        ringbuf_i16_read_buf(&rbuf, out, block);
+        sum += out[block - 1];
+    }
+    double elapsed = host_seconds() - start;
+    host_sink = sum;
+    return BENCH_SAMPLES / elapsed;
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < RINGBUF_I16_CAPACITY; i++)
+        in[i] = i * 7;
+
+    printf("block  per sample Msamples/s  block copy Msamples/s\n");
+    // Odd sizes so the blocks straddle the wrap at every offset
+    const size_t blocks[] = { 1, 3, 16, 48, 96, 193, 512, 1000 };
+    for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+        double best_sample = 0, best_block = 0;
+        for (int rep = 0; rep < 3; rep++) {
+            double s = bench_per_sample(blocks[b]);
+            double k = bench_block(blocks[b]);
+            best_sample = s > best_sample ? s : best_sample;
+            best_block = k > best_block ? k : best_block;
+        }
+        printf("%5zu  %22.1f  %20.1f\n", blocks[b], best_sample * 1e-6, best_block * 1e-6);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Constant against runtime capacity for the same SPSC ring: ringbuf_i16
+// from the family, and a copy of its code with the capacity, and so the
+// mask, read from the struct as the runtime-sized ring it replaced did.
+
+#include <string.h>
+#include <stdatomic.h>
+#include "host_test.h"
+#include "ringbuf_i16.h"
+
+#define BENCH_SAMPLES           (1u << 26)
+
+typedef struct {
+    atomic_uint write;
+    uint8_t pad0[RINGBUF_CACHE_LINE];
+    atomic_uint read;
+    uint8_t pad1[RINGBUF_CACHE_LINE];
+    uint32_t capacity;
+    int16_t *buffer;
+} runtime_ring_t;
+
+static __attribute__((noinline)) bool runtime_write(runtime_ring_t *rbuf, int16_t val)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    if (write - read == rbuf->capacity)
+        return false;
+    rbuf->buffer[write & (rbuf->capacity - 1)] = val;
+    atomic_store_explicit(&rbuf->write, write + 1, memory_order_release);
+    return true;
+}
+
+static __attribute__((noinline)) int16_t runtime_read(runtime_ring_t *rbuf)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    int16_t val = rbuf->buffer[read & (rbuf->capacity - 1)];
+    atomic_store_explicit(&rbuf->read, read + 1, memory_order_release);
+    return val;
+}
+
+static __attribute__((noinline)) size_t runtime_write_buf(runtime_ring_t *rbuf, const int16_t *buf, size_t size)
+{
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_acquire);
+    size_t avail = rbuf->capacity - (write - read);
+    if (size > avail)
+        size = avail;
+    uint32_t start = write & (rbuf->capacity - 1);
+    size_t first = rbuf->capacity - start;
+    if (first > size)
+        first = size;
+    memcpy(&rbuf->buffer[start], buf, first * sizeof(int16_t));
+    memcpy(rbuf->buffer, buf + first, (size - first) * sizeof(int16_t));
+    atomic_store_explicit(&rbuf->write, write + size, memory_order_release);
+    return size;
+}
+
+static __attribute__((noinline)) size_t runtime_read_buf(runtime_ring_t *rbuf, int16_t *buf, size_t size)
+{
+    uint32_t read = atomic_load_explicit(&rbuf->read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&rbuf->write, memory_order_acquire);
+    size_t count = write - read;
+    if (size > count)
+        size = count;
+    uint32_t start = read & (rbuf->capacity - 1);
+    size_t first = rbuf->capacity - start;
+    if (first > size)
+        first = size;
+    memcpy(buf, &rbuf->buffer[start], first * sizeof(int16_t));
+    memcpy(buf + first, rbuf->buffer, (size - first) * sizeof(int16_t));
+    atomic_store_explicit(&rbuf->read, read + size, memory_order_release);
+    return size;
+}
+
+static ringbuf_i16_t constant;
+static runtime_ring_t runtime;
+static int16_t in[96], out[96];
+
+int main(void)
+{
+    runtime.capacity = RINGBUF_I16_CAPACITY;
+    runtime.buffer = calloc(RINGBUF_I16_CAPACITY, sizeof(int16_t));
+
+    double best[4] = { 0 };
+    for (int rep = 0; rep < 5; rep++) {
+        double t[4];
+        int64_t sum = 0;
+
+        ringbuf_i16_reset(&constant);
+        double start = host_seconds();
+        for (uint32_t n = 0; n < BENCH_SAMPLES; n += 48) {
+            for (int i = 0; i < 48; i++)
+                ringbuf_i16_write(&constant, i);
+            for (int i = 0; i < 48; i++)
+                sum += ringbuf_i16_read(&constant);
+        }
+        t[0] = host_seconds() - start;
+
+        atomic_init(&runtime.write, 0);
+        atomic_init(&runtime.read, 0);
+        start = host_seconds();
+        for (uint32_t n = 0; n < BENCH_SAMPLES; n += 48) {
+            for (int i = 0; i < 48; i++)
+                runtime_write(&runtime, i);
+            for (int i = 0; i < 48; i++)
+                sum += runtime_read(&runtime);
+        }
+        t[1] = host_seconds() - start;
+
+        // 93 keeps the blocks moving across the wrap
+        start = host_seconds();
+        for (uint32_t n = 0; n < BENCH_SAMPLES; n += 93) {
+            ringbuf_i16_write_buf(&constant, in, 93);
+            ringbuf_i16_read_buf(&constant, out, 93);
+            sum += out[92];
+        }
+        t[2] = host_seconds() - start;
+
+        start = host_seconds();
+        for (uint32_t n = 0; n < BENCH_SAMPLES; n += 93) {
+            runtime_write_buf(&runtime, in, 93);
+            runtime_read_buf(&runtime, out, 93);
+            sum += out[92];
+        }
+        t[3] = host_seconds() - start;
+
+        host_sink = sum;
+        for (int i = 0; i < 4; i++) {
+            double rate = BENCH_SAMPLES / t[i] * 1e-6;
+            best[i] = rate > best[i] ? rate : best[i];
+        }
+    }
+
+    printf("Msamples/s, best of 5   constant mask  runtime mask\n");
+    printf("per sample write/read   %13.1f  %12.1f\n", best[0], best[1]);
+    printf("93 sample block copy    %13.1f  %12.1f\n", best[2], best[3]);
+    free(runtime.buffer);
+    return 0;
+}
@@ -0,0 +1,209 @@
+// Cost of each sink's whole per-packet chain against its real time budget,
+// the host model of what usb_cb_us_max and i2s_us_max measure on the
+// device. The ESP-NOW side writes 1 ms of a two-tone stream into the
+// broadcast ring every millisecond and both sinks read it:
+//
+//   USB, every 1 ms: pacer, read_frames, PLC, resample when the host runs
+//   at 44.1 kHz, -12 dB gain, and the copy tud_audio_write makes
+//   I2S, every 2 ms: read_frames, ASRC, and the copy into the DMA buffers
+//   i2s_write makes
+//
+// Each case runs 10 s of audio, clean and with a 20 ms dropout every
+// 500 ms so the sinks go through concealment and refill. Mean, 99.9th
+// percentile and worst call are reported, best mean of 3 runs, with the
+// share of the sink's period the worst call takes.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ringbuf_bcast.h"
+#include "usb_pacer.h"
+#include "plc.h"
+#include "resample.h"
+#include "gain.h"
+#include "asrc.h"
+
+#define STREAM_RATE             48000
+#define STREAM_BLOCK            48              // Frames written per 1 ms
+#define RUN_MS                  10000
+#define USB_FILL_FRAMES         (48 * 8)        // As usb_audio_cb.c
+#define I2S_FILL_FRAMES         (48 * 2 * 4)    // As war_i2s_audio.c
+#define I2S_FRAMES              (48 * 2)
+#define I2S_PERIOD_MS           2
+
+static ringbuf_bcast_t rb;
+static usb_pacer_t pacer;
+static plc_t plc;
+static resample_t resample;
+static gain_t gain;
+static asrc_t asrc;
+static int usb_reader, i2s_reader;
+static bool usb_filling, i2s_filling;
+
+static audio_sample_t block[STREAM_BLOCK * AUDIO_CHANNELS];
+static audio_sample_t usb_in[RESAMPLE_MAX_IN * AUDIO_CHANNELS], usb_data[USB_PACER_MAX_FRAMES * AUDIO_CHANNELS];
+static audio_sample_t usb_ep[USB_PACER_MAX_FRAMES * AUDIO_CHANNELS];
+static audio_sample_t i2s_in[ASRC_MAX_IN * AUDIO_CHANNELS], i2s_buf[I2S_FRAMES * AUDIO_CHANNELS];
+static audio_sample_t i2s_dma[I2S_FRAMES * AUDIO_CHANNELS];
+
+static uint64_t usb_cycles[RUN_MS], i2s_cycles[RUN_MS / I2S_PERIOD_MS];
+
+static void write_ms(uint32_t ms)
+{
+    for (int i = 0; i < STREAM_BLOCK; i++) {
+        double t = (double)(ms * STREAM_BLOCK + i) / STREAM_RATE;
+        double x = 0.3 * sin(2 * M_PI * 441 * t) + 0.2 * sin(2 * M_PI * 1234 * t);
+        for (int c = 0; c < AUDIO_CHANNELS; c++)
+            block[i * AUDIO_CHANNELS + c] = (audio_sample_t)lrint(x * 32767) << AUDIO_SAMPLE_SHIFT;
+    }
+    ringbuf_bcast_write(&rb, block, STREAM_BLOCK * AUDIO_CHANNELS);
+}
+
+// tud_audio_tx_done_pre_load_cb in asynchronous mode
+static void usb_callback(void)
+{
+    size_t frames = usb_pacer_frames(&pacer);
+    size_t want = resample_active(&resample) ? resample_input_frames(&resample, frames) : frames;
+    if (!usb_filling) {
+        if (ringbuf_bcast_read_frames(&rb, usb_reader, usb_in, want)) {
+            plc_good_frame(&plc, usb_in, want);
+            usb_pacer_steer(&pacer, ringbuf_bcast_size(&rb, usb_reader) / AUDIO_CHANNELS, want);
+        } else {
+            usb_filling = true;
+            plc_conceal(&plc, usb_in, want);
+        }
+    } else {
+        usb_filling = ringbuf_bcast_size(&rb, usb_reader) < USB_FILL_FRAMES * AUDIO_CHANNELS;
+        plc_conceal(&plc, usb_in, want);
+    }
+    audio_sample_t *out = usb_in;
+    if (resample_active(&resample)) {
+        resample_process(&resample, out, usb_data, frames);
+        out = usb_data;
+    }
+    gain_apply(&gain, out, frames);
+    memcpy(usb_ep, out, frames * AUDIO_CHANNELS * sizeof(audio_sample_t));
+}
+
+// One pass of war_i2s_audio_task, up to the blocking i2s_write
+static void i2s_frame(void)
+{
+    size_t want = asrc_input_frames(&asrc, I2S_FRAMES);
+    bool got = false;
+    if (i2s_filling) {
+        i2s_filling = ringbuf_bcast_size(&rb, i2s_reader) < I2S_FILL_FRAMES * AUDIO_CHANNELS;
+    } else {
+        got = ringbuf_bcast_read_frames(&rb, i2s_reader, i2s_in, want);
+        i2s_filling = !got;
+        if (got)
+            asrc_steer(&asrc, ringbuf_bcast_size(&rb, i2s_reader) / AUDIO_CHANNELS, I2S_FRAMES);
+    }
+    if (!got)
+        memset(i2s_in, 0, want * AUDIO_CHANNELS * sizeof(audio_sample_t));
+    asrc_process(&asrc, i2s_in, i2s_buf, I2S_FRAMES);
+    memcpy(i2s_dma, i2s_buf, sizeof(i2s_buf));
+}
+
+static void start(uint32_t host_rate)
+{
+    ringbuf_bcast_reset(&rb);
+    usb_reader = ringbuf_bcast_add_reader(&rb);
+    i2s_reader = ringbuf_bcast_add_reader(&rb);
+    ringbuf_bcast_set_active(&rb, usb_reader, true);
+    ringbuf_bcast_set_active(&rb, i2s_reader, true);
+    usb_pacer_init(&pacer, host_rate, USB_FILL_FRAMES);
+    plc_init(&plc);
+    resample_init(&resample, STREAM_RATE, host_rate);
+    gain_init(&gain);
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        gain_set(&gain, ch, gain_from_db(-12 * 256));
+    asrc_init(&asrc, I2S_FILL_FRAMES);
+    usb_filling = i2s_filling = true;
+}
+
+static void run(uint32_t host_rate, bool dropouts)
+{
+    start(host_rate);
+    for (uint32_t ms = 0; ms < RUN_MS; ms++) {
+        if (!dropouts || ms % 500 < 480)
+            write_ms(ms);
+
+        uint64_t t = host_cycles();
+        usb_callback();
+        usb_cycles[ms] = host_cycles() - t;
+
+        if (ms % I2S_PERIOD_MS == 0) {
+            t = host_cycles();
+            i2s_frame();
+            i2s_cycles[ms / I2S_PERIOD_MS] = host_cycles() - t;
+        }
+    }
+    host_sink = usb_ep[0] + i2s_dma[0];
+}
+
+static int compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+typedef struct {
+    double mean;
+    uint64_t p999;
+    uint64_t max;
+} stats_t;
+
+static stats_t stats_of(uint64_t *cycles, size_t n)
+{
+    stats_t s = { 0, 0, 0 };
+    qsort(cycles, n, sizeof(cycles[0]), compare);
+    for (size_t i = 0; i < n; i++)
+        s.mean += cycles[i];
+    s.mean /= n;
+    s.p999 = cycles[n * 999 / 1000];
+    s.max = cycles[n - 1];
+    return s;
+}
+
+static void report(const char *sink, const stats_t *s, double budget)
+{
+    printf("  %-4s %9.0f %9lu %9lu   %5.2f%%\n", sink, s->mean, (unsigned long)s->p999, (unsigned long)s->max,
+           100.0 * s->max / budget);
+}
+
+static void bench(uint32_t host_rate, bool dropouts, double cycles_per_ms)
+{
+    stats_t usb = { 1e18, 0, 0 }, i2s = { 1e18, 0, 0 };
+    for (int rep = 0; rep < 3; rep++) {
+        run(host_rate, dropouts);
+        stats_t u = stats_of(usb_cycles, RUN_MS), s = stats_of(i2s_cycles, RUN_MS / I2S_PERIOD_MS);
+        if (u.mean < usb.mean)
+            usb = u;
+        if (s.mean < i2s.mean)
+            i2s = s;
+    }
+    printf("host at %u Hz, %s\n", host_rate, dropouts ? "20 ms dropout every 500 ms" : "clean");
+    printf("  sink      mean     p99.9       max   max/period\n");
+    report("USB", &usb, cycles_per_ms);
+    report("I2S", &i2s, cycles_per_ms * I2S_PERIOD_MS);
+}
+
+int main(void)
+{
+    // The budget in the unit host_cycles counts
+    double t = host_seconds();
+    uint64_t c = host_cycles();
+    while (host_seconds() - t < 0.2)
+        ;
+    double cycles_per_ms = (host_cycles() - c) / (host_seconds() - t) / 1000;
+
+    printf("%d channel(s), %d bytes per sample, %s per call, 1 ms = %.0f\n", AUDIO_CHANNELS,
+           AUDIO_BYTES_PER_SAMPLE, HOST_CYCLE_UNIT, cycles_per_ms);
+    resample_prepare(STREAM_RATE, 44100);
+    bench(48000, false, cycles_per_ms);
+    bench(48000, true, cycles_per_ms);
+    bench(44100, false, cycles_per_ms);
+    bench(44100, true, cycles_per_ms);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+/*
+ * Helpers shared by the host tests, simulations and benchmarks. Each is one
+ * translation unit built against the modules in main/, see CMakeLists.txt.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static int host_failures;
+
+#define CHECK(cond) host_check((cond), #cond, __FILE__, __LINE__)
+
+static inline void host_check(int ok, const char* what, const char* file, int line)
+{
+    if (ok)
+        return;
+    if (host_failures++ < 20)
+        printf("FAIL %s:%d: %s\n", file, line, what);
+}
+
+// Prints the summary line and gives main's exit status
+static inline int host_result(const char* name)
+{
+    printf("%s: %s (%d failures)\n", name, host_failures ? "FAILED" : "passed", host_failures);
+    return host_failures != 0;
+}
+
+// xorshift32, deterministic for a seed so every run replays the same case
+static inline uint32_t host_rand(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// 0..n-1
+static inline uint32_t host_rand_below(uint32_t* state, uint32_t n)
+{
+    return (uint32_t)(((uint64_t)host_rand(state) * n) >> 32);
+}
+
+// Timestamp counter on x86, nanoseconds elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+#define HOST_CYCLE_UNIT         "TSC cycles"
+static inline uint64_t host_cycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define HOST_CYCLE_UNIT         "ns"
+static inline uint64_t host_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+static inline double host_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keeps a result alive so the benchmarked work is not optimised away
+static volatile int64_t host_sink;
+
+#endif // __HOST_TEST_H__
@@ -0,0 +1,204 @@
+// Channel selection and following against synthetic per-channel traces:
+// 2 ms packets for 300 s, feedback every 250 ms heard only while receiver
+// and transmitter share a channel, probes answered from the trace. The
+// migration itself is instant and the scans take no time. Checks when and
+// where the link moves, how long the receiver is off the air, and that the
+// dwell time holds back a link that keeps degrading.
+
+#include <string.h>
+#include "host_test.h"
+#include "channel.h"
+
+#define PACKET_MS               2
+#define DURATION_MS             300000
+#define FEEDBACK_MS             250
+#define LEAD                    16              // Packets announced ahead, ESPNOW_CHANNEL_LEAD
+#define MASK                    ((1 << 1) | (1 << 6) | (1 << 8) | (1 << 11))
+
+typedef struct {
+    uint32_t loss;                              // Permille
+    uint8_t networks;
+    int8_t strongest, noise;
+} conditions_t;
+
+typedef enum {
+    SCENARIO_CLEAN,
+    SCENARIO_CONGESTION,                        // Channel 8 turns bad at 60 s
+    SCENARIO_DEAF,                              // As congestion, every announcement lost
+    SCENARIO_CHASED,                            // Whatever channel the link is on turns bad after 5 s
+} scenario_t;
+
+typedef struct {
+    uint32_t sent, received, lost_on_air, off_channel, longest_gap;
+    uint32_t migrations, probes;
+    int64_t first_migration_ms, min_dwell_ms;
+    uint8_t first_target, final_tx, final_rx;
+} sim_result_t;
+
+static conditions_t env[CHANNEL_MAX + 1];
+static uint32_t seed;
+
+static bool lost(uint32_t permille)
+{
+    return host_rand_below(&seed, 1000) < permille;
+}
+
+static void calm(void)
+{
+    for (int c = 1; c <= CHANNEL_MAX; c++)
+        env[c] = (conditions_t){ 5, 3, -75, -95 };
+    env[1] = (conditions_t){ 2, 1, -85, -96 };
+    env[6] = (conditions_t){ 10, 6, -60, -93 };
+    env[8] = (conditions_t){ 3, 2, -80, -96 };
+    env[11] = (conditions_t){ 8, 4, -70, -94 };
+}
+
+static const conditions_t bad = { 150, 9, -45, -88 };
+
+static sim_result_t run(scenario_t scenario)
+{
+    channel_ctrl_t tx;
+    channel_follow_t rx;
+    sim_result_t res = { .first_migration_ms = -1, .min_dwell_ms = INT64_MAX };
+    uint8_t tx_ch = 8, target = 0;
+    uint32_t seq = 0, switch_seq = 0, fb_received = 0, fb_expected = 0, gap = 0;
+    bool announcing = false;
+    int64_t last_feedback = 0, moved_ms = 0, last_migration = -1;
+
+    seed = 1;
+    calm();
+    channel_ctrl_init(&tx, tx_ch, MASK, 0);
+    channel_follow_init(&rx, tx_ch, MASK, 0);
+    for (int64_t t = 0; t < DURATION_MS; t += PACKET_MS) {
+        if ((scenario == SCENARIO_CONGESTION || scenario == SCENARIO_DEAF) && t == 60000)
+            env[8] = bad;
+        if (scenario == SCENARIO_CHASED && t == moved_ms + 5000) {
+            calm();
+            env[tx_ch] = bad;
+        }
+
+        // The transmitter moves right before the announced packet
+        if (announcing && seq == switch_seq) {
+            tx_ch = target;
+            channel_ctrl_switched(&tx, target, t);
+            announcing = false;
+            moved_ms = t;
+            if (res.first_migration_ms < 0) {
+                res.first_migration_ms = t;
+                res.first_target = target;
+            }
+            if (last_migration >= 0 && t - last_migration < res.min_dwell_ms)
+                res.min_dwell_ms = t - last_migration;
+            last_migration = t;
+        }
+        if (announcing && seq % 4 == 0 && rx.current == tx_ch && !lost(env[tx_ch].loss) &&
+            scenario != SCENARIO_DEAF)
+            channel_follow_announce(&rx, target, switch_seq);
+
+        // One audio packet
+        uint8_t move = 0;
+        res.sent++;
+        fb_expected++;
+        if (rx.current != tx_ch) {
+            res.off_channel++;
+            gap++;
+        } else if (lost(env[tx_ch].loss)) {
+            res.lost_on_air++;
+            gap++;
+        } else {
+            res.received++;
+            fb_received++;
+            res.longest_gap = gap > res.longest_gap ? gap : res.longest_gap;
+            gap = 0;
+            move = channel_follow_packet(&rx, seq, t);
+        }
+        seq++;
+        if (!move)
+            move = channel_follow_tick(&rx, t);
+        if (move)
+            rx.current = move;
+
+        if (t - last_feedback >= FEEDBACK_MS) {
+            last_feedback = t;
+            if (rx.current == tx_ch && fb_expected) {
+                channel_link_sample_t s = {
+                    .loss_permille = (fb_expected - fb_received) * 1000 / fb_expected,
+                    .retry_permille = env[tx_ch].loss / 4,
+                    .rssi = -55,
+                    .noise = env[tx_ch].noise,
+                };
+                channel_ctrl_link(&tx, &s);
+            }
+            fb_received = fb_expected = 0;
+        }
+
+        uint8_t probe = channel_ctrl_next_probe(&tx, t);
+        if (probe) {
+            channel_probe_t p = { env[probe].networks, env[probe].strongest };
+            channel_ctrl_probed(&tx, probe, &p, t);
+        }
+        if (!announcing) {
+            uint8_t pick = channel_ctrl_pick(&tx, t);
+            if (pick) {
+                announcing = true;
+                target = pick;
+                switch_seq = seq + LEAD;
+            }
+        }
+    }
+
+    res.migrations = tx.stats.migrations;
+    res.probes = tx.stats.probes;
+    res.final_tx = tx_ch;
+    res.final_rx = rx.current;
+    return res;
+}
+
+static void print(const char *name, const sim_result_t *r)
+{
+    printf("%-12s  %8u  %8u  %7u  %10u  %6u  %7.1f  %5u\n", name, r->lost_on_air, r->off_channel,
+           r->longest_gap, r->migrations, r->probes,
+           r->first_migration_ms < 0 ? 0 : r->first_migration_ms / 1000.0, r->final_tx);
+}
+
+int main(void)
+{
+    sim_result_t r;
+
+    printf("trace         lost air  off chan  max gap  migrations  probes  first s  final\n");
+
+    // A good channel stays put and nothing is probed
+    r = run(SCENARIO_CLEAN);
+    print("clean", &r);
+    CHECK(r.migrations == 0 && r.probes == 0 && r.off_channel == 0);
+
+    // Congestion on 8: probe, move to the quietest channel within seconds,
+    // receiver follows the announcement without missing a packet
+    r = run(SCENARIO_CONGESTION);
+    print("congestion", &r);
+    CHECK(r.migrations == 1 && r.first_target == 1);
+    CHECK(r.first_migration_ms > 60000 && r.first_migration_ms < 70000);
+    CHECK(r.off_channel == 0);
+    CHECK(r.longest_gap < 10);
+    CHECK(r.final_tx == 1 && r.final_rx == 1);
+
+    // Every announcement lost: the receiver notices the silence and hunts,
+    // back within CHANNEL_LOST_MS plus a hunt over the four channels
+    r = run(SCENARIO_DEAF);
+    print("deaf", &r);
+    CHECK(r.migrations == 1 && r.final_rx == r.final_tx);
+    CHECK(r.off_channel > 0);
+    CHECK(r.longest_gap * PACKET_MS <= CHANNEL_LOST_MS + 4 * CHANNEL_HUNT_DWELL_MS + 100);
+
+    // A link that keeps degrading: the dwell time spaces the migrations
+    r = run(SCENARIO_CHASED);
+    print("chased", &r);
+    CHECK(r.migrations >= 2 && r.migrations <= DURATION_MS / CHANNEL_MIN_DWELL_MS);
+    CHECK(r.min_dwell_ms >= CHANNEL_MIN_DWELL_MS);
+    // Announcements reach the receiver over a bad channel, but the packet
+    // that moves it may not: it then follows after CHANNEL_FOLLOW_MS
+    CHECK(r.longest_gap * PACKET_MS <= CHANNEL_FOLLOW_MS + 10 * PACKET_MS);
+    CHECK(r.final_rx == r.final_tx);
+
+    return host_result("sim_channel");
+}
@@ -0,0 +1,149 @@
+// fec_xor over simulated loss: random and bursty channels at several loss
+// rates, single send against a second copy and XOR parity for K = 2, 4, 8.
+// Checks that every rebuilt payload is bit exact, that a group with one loss
+// is always repaired, and that the residual loss matches the model for
+// independent losses. Prints the residual loss and the airtime per audio
+// packet for each scheme.
+
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "fec_xor.h"
+#include "espnow_proto.h"
+
+#define PACKETS                 200000
+#define PAYLOAD                 96              // 1 ms of mono 16-bit PCM
+#define HEADER                  sizeof(espnow_data_t)
+
+typedef struct {
+    uint32_t seed;
+    double p;                                   // Loss rate
+    double burst;                               // Mean burst length, 1 for independent losses
+    bool bad;
+} channel_t;
+
+// Gilbert model with the given average loss and mean burst length
+static bool channel_lost(channel_t *ch)
+{
+    double u = host_rand(&ch->seed) / 4294967296.0;
+    if (ch->burst <= 1)
+        return u < ch->p;
+    double leave = 1 / ch->burst;
+    double enter = ch->p * leave / (1 - ch->p);
+    ch->bad = ch->bad ? u >= leave : u < enter;
+    return ch->bad;
+}
+
+static uint16_t payload_of(uint32_t seq, uint8_t *out)
+{
+    uint16_t len = PAYLOAD - seq % 7;           // Some shorter packets
+    uint32_t s = seq * 2654435761u + 1;
+    for (uint16_t i = 0; i < len; i++)
+        out[i] = host_rand(&s);
+    return len;
+}
+
+typedef struct {
+    double residual;
+    double airtime;                             // Bytes sent per audio packet, relative to single send
+} result_t;
+
+static result_t run(channel_t ch, int scheme)
+{
+    static uint8_t played[PACKETS];
+    static fec_encoder_t enc;
+    static fec_decoder_t dec;
+    uint8_t payload[FEC_MAX_PAYLOAD], expect[FEC_MAX_PAYLOAD];
+    uint64_t bytes = 0;
+
+    memset(played, 0, sizeof(played));
+    fec_encoder_init(&enc);
+    fec_decoder_init(&dec);
+    for (uint32_t seq = 0; seq < PACKETS; seq++) {
+        uint16_t len = payload_of(seq, payload);
+        int copies = scheme < 0 ? 2 : 1;
+        for (int c = 0; c < copies; c++) {
+            bytes += HEADER + len;
+            if (!channel_lost(&ch)) {
+                played[seq] = 1;
+                if (scheme > 0) {
+                    uint32_t lost;
+                    const uint8_t *out;
+                    uint16_t out_len;
+                    CHECK(!fec_decoder_add(&dec, seq, scheme, false, payload, len, &lost, &out, &out_len));
+                }
+            }
+        }
+        if (scheme > 0 && fec_encoder_add(&enc, scheme, payload, len)) {
+            bytes += HEADER + enc.len;
+            if (channel_lost(&ch))
+                continue;
+            uint32_t base = seq + 1 - scheme, lost;
+            const uint8_t *out;
+            uint16_t out_len;
+            uint32_t missing = 0;
+            for (uint32_t s = base; s <= seq; s++)
+                missing += !played[s];
+            bool rebuilt = fec_decoder_add(&dec, base, scheme, true, enc.parity, enc.len, &lost, &out, &out_len);
+            CHECK(rebuilt == (missing == 1));
+            if (rebuilt) {
+                CHECK(lost >= base && lost <= seq && !played[lost]);
+                CHECK(out_len == payload_of(lost, expect));
+                CHECK(memcmp(out, expect, out_len) == 0);
+                played[lost] = 1;
+            }
+        }
+    }
+
+    uint32_t missing = 0;
+    for (uint32_t seq = 0; seq < PACKETS; seq++)
+        missing += !played[seq];
+    return (result_t){
+        .residual = (double)missing / PACKETS,
+        .airtime = (double)bytes / (PACKETS * (HEADER + PAYLOAD - 3.0)),
+    };
+}
+
+int main(void)
+{
+    const double rates[] = { 0.01, 0.02, 0.05, 0.1, 0.2 };
+    const double bursts[] = { 1, 3 };
+    const int schemes[] = { 0, -1, 2, 4, 8 };   // Single, copy, K
+    uint32_t seed = 1;
+
+    printf("loss  burst   single     copy      K=2      K=4      K=8   (residual loss %%)\n");
+    for (size_t b = 0; b < 2; b++) {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            double p = rates[r];
+            printf("%4.0f%%  %5.0f", p * 100, bursts[b]);
+            for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); s++) {
+                channel_t ch = { .seed = seed++, .p = p, .burst = bursts[b] };
+                result_t res = run(ch, schemes[s]);
+                printf("  %7.3f", res.residual * 100);
+
+                // Independent losses: a packet stays lost when it and every
+                // other copy, or another packet or the parity of its group,
+                // is lost
+                double model = p;
+                if (schemes[s] < 0)
+                    model = p * p;
+                else if (schemes[s] > 0)
+                    model = p * (1 - pow(1 - p, schemes[s]));
+                double sigma = sqrt(model / PACKETS);
+                if (bursts[b] == 1)
+                    CHECK(fabs(res.residual - model) < 5 * sigma + 1e-5);
+                else
+                    CHECK(res.residual <= p * 1.2);
+            }
+            printf("\n");
+        }
+    }
+
+    printf("airtime per audio packet, %zu byte header, %d byte payload:", HEADER, PAYLOAD);
+    for (size_t s = 0; s < sizeof(schemes) / sizeof(schemes[0]); s++) {
+        channel_t ch = { .seed = 1, .p = 0 };
+        printf("  %.3f", run(ch, schemes[s]).airtime);
+    }
+    printf("\n");
+    return host_result("sim_fec_xor");
+}
@@ -0,0 +1,115 @@
+// PHY rate control against SNR profiles: 120 s of 220-byte frames at 500/s,
+// each rate losing frames on a logistic curve around its SNR threshold, a
+// report every 250 ms that only gets back when the receiver heard
+// something. Compares delivery and airtime with fixed 36M and 6M and checks
+// the adaptive controller against both.
+
+#include <math.h>
+#include "host_test.h"
+#include "rate_ctrl.h"
+
+#define DURATION_MS             120000
+#define PACKET_MS               2
+#define FRAME_BYTES             220
+#define REPORT_MS               250
+
+// SNR in dB where each rate loses half its frames, roughly the spread of
+// 802.11g receiver sensitivities
+static const double threshold_db[RATE_COUNT] = { 5, 6, 8, 10, 13, 17, 21, 23 };
+
+typedef double (*profile_t)(double t);
+
+static double clean(double t) { return 35; }
+static double middle(double t) { return 19; }
+static double edge(double t) { return 9; }
+static double fading(double t) { return 20 + 10 * sin(t * 2 * M_PI / 20); }
+static double walk_away(double t) { return 35 - t * 0.25; }
+static double dropout(double t) { return t >= 60 && t < 63 ? -20 : 30; }
+
+typedef struct {
+    double delivered, airtime;                  // Fractions
+    rate_t final;
+    rate_ctrl_stats_t stats;
+} sim_result_t;
+
+static double frame_error(rate_t rate, double snr)
+{
+    return 1.0 / (1.0 + exp((snr - threshold_db[rate]) * 1.5));
+}
+
+static sim_result_t run(profile_t snr, bool adapt, rate_t fixed)
+{
+    rate_ctrl_t ctrl;
+    uint32_t seed = 12345;
+    uint64_t sent = 0, received = 0, air_us = 0;
+    uint32_t window_sent = 0, window_received = 0;
+
+    rate_ctrl_init(&ctrl, RATE_36M, 0);
+    rate_ctrl_set_load(&ctrl, FRAME_BYTES, 1000 / PACKET_MS);
+    rate_t rate = adapt ? ctrl.active : fixed;
+    for (int64_t t = 0; t < DURATION_MS; t += PACKET_MS) {
+        sent++;
+        window_sent++;
+        air_us += rate_ctrl_airtime_us(rate, FRAME_BYTES);
+        if (host_rand(&seed) / 4294967296.0 >= frame_error(rate, snr(t / 1000.0))) {
+            received++;
+            window_received++;
+        }
+        if (t % REPORT_MS == 0 && t) {
+            if (adapt && window_received)
+                rate = rate_ctrl_report(&ctrl, window_received, window_sent, window_sent, 0, t);
+            window_sent = window_received = 0;
+        }
+        if (adapt)
+            rate = rate_ctrl_tick(&ctrl, t);
+    }
+    return (sim_result_t){
+        .delivered = (double)received / sent,
+        .airtime = air_us / (DURATION_MS * 1000.0),
+        .final = rate,
+        .stats = ctrl.stats,
+    };
+}
+
+int main(void)
+{
+    const struct {
+        const char *name;
+        profile_t snr;
+        double min_delivered;                   // Adaptive must reach this
+    } profiles[] = {
+        { "clean 35 dB", clean, 0.999 },
+        { "19 dB", middle, 0.995 },
+        { "9 dB", edge, 0.97 },
+        { "fading 10-30 dB", fading, 0.985 },
+        { "35 -> 5 dB", walk_away, 0.97 },
+        { "3 s dropout", dropout, 0.97 },
+    };
+
+    printf("profile            fixed 36M         fixed 6M          adaptive          changes  samples\n");
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(profiles[0]); p++) {
+        sim_result_t fast = run(profiles[p].snr, false, RATE_36M);
+        sim_result_t slow = run(profiles[p].snr, false, RATE_6M);
+        sim_result_t adapt = run(profiles[p].snr, true, 0);
+        printf("%-16s  %6.2f%% %4.1f%% air  %6.2f%% %4.1f%% air  %6.2f%% %4.1f%% air  %7u  %7u\n",
+               profiles[p].name, fast.delivered * 100, fast.airtime * 100, slow.delivered * 100,
+               slow.airtime * 100, adapt.delivered * 100, adapt.airtime * 100, adapt.stats.changes,
+               adapt.stats.samples);
+
+        CHECK(adapt.delivered >= profiles[p].min_delivered);
+        // Never worse than the fast rate, never as expensive as the slow one
+        CHECK(adapt.delivered >= fast.delivered - 0.001);
+        CHECK(adapt.airtime < slow.airtime);
+        CHECK(adapt.airtime * 1000 <= RATE_AIRTIME_MAX);
+    }
+
+    // A clean link ends up faster than it started and spends less air
+    sim_result_t r = run(clean, true, 0);
+    CHECK(r.final > RATE_36M);
+    CHECK(r.airtime < run(clean, false, RATE_36M).airtime);
+    // After a dropout the rate climbs back
+    r = run(dropout, true, 0);
+    CHECK(r.final >= RATE_36M);
+
+    return host_result("sim_rate_ctrl");
+}
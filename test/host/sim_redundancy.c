@@ -0,0 +1,174 @@
+// redundancy controller replayed against synthetic loss traces. Each report
+// covers 125 audio packets sent at the current level over a channel with the
+// trace's loss for that report; copies and XOR parity (K = 3) repair what
+// they can and the receiver's counts go back into the controller. Checks
+// the expected behaviour of each trace and prints changes, packets lost at
+// playout and the airtime spent.
+
+#include <string.h>
+#include "host_test.h"
+#include "redundancy.h"
+
+#define PACKETS_PER_REPORT      125             // 250 ms of 2 ms packets
+#define REPORTS                 400
+#define FEC_K                   3
+
+typedef struct {
+    uint32_t seed;
+    uint32_t burst;                             // Mean burst length, 1 for independent
+    bool bad;
+} channel_t;
+
+typedef struct {
+    uint32_t changes, lost, sent, audio;
+    redundancy_level_t final;
+    redundancy_level_t levels[REPORTS];
+} trace_result_t;
+
+// permille loss, Gilbert model when burst > 1
+static bool lost_on_air(channel_t *ch, uint32_t permille)
+{
+    uint32_t u = host_rand_below(&ch->seed, 1000000);
+    if (ch->burst <= 1)
+        return u < permille * 1000;
+    uint32_t leave = 1000000 / ch->burst;
+    uint32_t enter = (uint64_t)permille * leave / (1000 - permille);
+    ch->bad = ch->bad ? u >= leave : u < enter;
+    return ch->bad;
+}
+
+// Sends one report's worth of packets, returns the receiver's counts
+static void send_report(channel_t *ch, redundancy_level_t level, uint32_t permille,
+                        uint32_t *received, uint32_t *expected, uint32_t *lost, uint32_t *sent)
+{
+    uint32_t copies = redundancy_copies(level);
+    *received = *expected = *lost = 0;
+    for (uint32_t p = 0; p < PACKETS_PER_REPORT; p += FEC_K) {
+        uint32_t missing = 0;
+        for (uint32_t i = 0; i < FEC_K; i++) {
+            bool got = false;
+            for (uint32_t c = 0; c <= copies; c++) {
+                bool ok = !lost_on_air(ch, permille);
+                *received += ok;
+                got |= ok;
+            }
+            *expected += copies + 1;
+            *sent += copies + 1;
+            missing += !got;
+        }
+        if (level == REDUNDANCY_FEC) {
+            (*sent)++;
+            if (missing == 1 && !lost_on_air(ch, permille))
+                missing = 0;
+        }
+        *lost += missing;
+    }
+}
+
+typedef uint32_t (*trace_t)(uint32_t report);
+
+static trace_result_t replay(const char *name, trace_t trace, redundancy_level_t start, uint32_t burst)
+{
+    redundancy_ctrl_t ctrl;
+    channel_t ch = { .seed = 1, .burst = burst };
+    trace_result_t res;
+    memset(&res, 0, sizeof(res));
+
+    redundancy_init(&ctrl, start, true);
+    redundancy_level_t level = ctrl.level;
+    for (uint32_t r = 0; r < REPORTS; r++) {
+        uint32_t received, expected, lost;
+        send_report(&ch, level, trace(r), &received, &expected, &lost, &res.sent);
+        res.lost += lost;
+        res.audio += PACKETS_PER_REPORT / FEC_K * FEC_K;
+        redundancy_level_t next = redundancy_update(&ctrl, received, expected, lost);
+        res.changes += next != level;
+        level = next;
+        res.levels[r] = level;
+    }
+    res.final = level;
+    printf("%-22s  %7u  %-8s  %6u  %7.2f\n", name, res.changes, redundancy_level_name(level), res.lost,
+           (double)res.sent / res.audio);
+    return res;
+}
+
+static uint32_t clean(uint32_t r) { return 0; }
+static uint32_t light(uint32_t r) { return 3; }
+static uint32_t heavy(uint32_t r) { return 120; }
+static uint32_t hovering(uint32_t r) { return r & 1 ? 24 : 16; }
+static uint32_t step(uint32_t r) { return r >= 100 && r < 200 ? 40 : 0; }
+static uint32_t spike(uint32_t r) { return r == 100 ? 300 : 0; }
+static uint32_t bursty(uint32_t r) { return 30; }
+
+// Moving between rooms: long stretches of low, medium and high loss
+static uint32_t walk(uint32_t r)
+{
+    static const uint32_t stages[] = { 2, 10, 40, 120, 40, 10, 2, 0 };
+    return stages[r / 50];
+}
+
+int main(void)
+{
+    trace_result_t res;
+
+    printf("trace                   changes  final     lost    airtime\n");
+
+    // Nothing lost: 1 copy steps down through FEC to none, one hold each
+    res = replay("clean", clean, REDUNDANCY_COPY1, 1);
+    CHECK(res.changes == 2 && res.final == REDUNDANCY_NONE && res.lost == 0);
+    CHECK(res.levels[REDUNDANCY_HOLD_REPORTS - 2] == REDUNDANCY_COPY1);
+    CHECK(res.levels[REDUNDANCY_HOLD_REPORTS - 1] == REDUNDANCY_FEC);
+    CHECK(res.levels[2 * REDUNDANCY_HOLD_REPORTS - 1] == REDUNDANCY_NONE);
+
+    // Below what sending once copes with stays there
+    res = replay("0.3% steady", light, REDUNDANCY_NONE, 1);
+    CHECK(res.final <= REDUNDANCY_FEC);
+    CHECK(res.lost < REPORTS * PACKETS_PER_REPORT * 5 / 1000);
+
+    // 12%: two copies from the first reports on, never lower
+    res = replay("12% steady", heavy, REDUNDANCY_NONE, 1);
+    CHECK(res.levels[2] == REDUNDANCY_COPY2);
+    CHECK(res.changes <= 3 && res.final == REDUNDANCY_COPY2);
+
+    // Hovering around what FEC copes with: 1 copy holds, no flapping
+    res = replay("2% +/- 0.4%", hovering, REDUNDANCY_COPY1, 1);
+    CHECK(res.changes == 0);
+
+    // 0 -> 4% -> 0: up within a report of the onset, to 1 copy within
+    // three, and down only after a full hold once it is clean again
+    res = replay("0 -> 4% -> 0", step, REDUNDANCY_NONE, 1);
+    CHECK(res.levels[99] == REDUNDANCY_NONE);
+    CHECK(res.levels[100] >= REDUNDANCY_FEC);
+    CHECK(res.levels[103] == REDUNDANCY_COPY1);
+    CHECK(res.levels[199 + REDUNDANCY_HOLD_REPORTS - 1] == REDUNDANCY_COPY1);
+    CHECK(res.final == REDUNDANCY_NONE);
+
+    // One bad report steps up at once and the level comes back down
+    res = replay("30% for one report", spike, REDUNDANCY_NONE, 1);
+    CHECK(res.levels[100] != REDUNDANCY_NONE);
+    CHECK(res.final == REDUNDANCY_NONE);
+
+    // 3% in bursts of 4: back to back copies fall in the same burst, so
+    // even two copies only about halve the loss, but it must go down
+    res = replay("3% in bursts of 4", bursty, REDUNDANCY_NONE, 4);
+    CHECK(res.final == REDUNDANCY_COPY2);
+    CHECK(res.lost < res.audio * 30 / 1000);
+
+    // Each stretch of the walk ends at the level that copes with it
+    res = replay("walk 0.2% .. 12%", walk, REDUNDANCY_COPY1, 1);
+    CHECK(res.levels[149] == REDUNDANCY_COPY1);
+    CHECK(res.levels[199] == REDUNDANCY_COPY2);
+    CHECK(res.final == REDUNDANCY_NONE);
+
+    // Two receivers feeding one controller: the worse keeps the level up
+    redundancy_ctrl_t ctrl;
+    redundancy_init(&ctrl, REDUNDANCY_NONE, true);
+    for (int r = 0; r < 100; r++) {
+        redundancy_update(&ctrl, 1000, 1000, 0);
+        redundancy_update(&ctrl, 950, 1000, 0);
+        if (r > 4)
+            CHECK(ctrl.level == REDUNDANCY_COPY1);
+    }
+
+    return host_result("sim_redundancy");
+}
@@ -0,0 +1,131 @@
+// USB pacer against simulated clock offsets. The transmitter's clock
+// produces 2 ms packets that arrive 0 to jitter ms late; the host's clock
+// polls one USB frame per ms and takes usb_pacer_frames() from the ring,
+// refilling to the target after an underrun as the USB callback does.
+// Checks, after a settling minute, that the rate the host sees matches the
+// transmitter's clock, that the ring stays around its target without
+// running dry or full, and that each USB frame carries the nominal count
+// or one either side.
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "host_test.h"
+#include "usb_pacer.h"
+
+#define TARGET_FILL             384
+#define RING_FRAMES             1024
+#define SETTLE_S                60
+
+typedef struct {
+    int32_t min_fill, max_fill;
+    uint32_t underruns, overruns, odd_sizes;
+    double ppm_error;                           // Host's view of the rate against the transmitter's clock
+    double pacer_ppm;                           // Mean correction
+} sim_result_t;
+
+static sim_result_t run(uint32_t rate, int tx_ppm, int rx_ppm, double seconds, double jitter_ms)
+{
+    usb_pacer_t pacer;
+    sim_result_t res = { .min_fill = INT32_MAX };
+    double tx_period = 0.002 / (1 + tx_ppm * 1e-6), rx_period = 0.001 / (1 + rx_ppm * 1e-6);
+    double next_tx = 0, next_rx = 0, start = 0;
+    double pending[64];                         // Arrival times, in order
+    int queued = 0;
+    int64_t fill = 0, packet_acc = 0, sent = 0, ppm_sum = 0, polls = 0;
+    bool filling = true;
+    uint32_t seed = 7;
+    int32_t nominal = rate / 1000;
+
+    usb_pacer_init(&pacer, rate, TARGET_FILL);
+    while (next_rx < seconds) {
+        while (next_tx <= next_rx) {
+            double arrive = next_tx + host_rand(&seed) / 4294967296.0 * jitter_ms * 1e-3;
+            if (queued && arrive < pending[queued - 1])
+                arrive = pending[queued - 1];
+            pending[queued++] = arrive;
+            next_tx += tx_period;
+        }
+        while (queued && pending[0] <= next_rx) {
+            packet_acc += rate;                 // 2 ms of frames, fractional part carried
+            fill += packet_acc / 500;
+            packet_acc %= 500;
+            if (fill > RING_FRAMES) {
+                res.overruns++;
+                fill = RING_FRAMES;
+            }
+            memmove(pending, pending + 1, --queued * sizeof(pending[0]));
+        }
+
+        bool settled = next_rx >= SETTLE_S;
+        int32_t n = usb_pacer_frames(&pacer);
+        if (filling) {
+            filling = fill < TARGET_FILL;
+        } else if (n > fill) {
+            res.underruns += settled;
+            fill = 0;
+            filling = true;
+        } else {
+            fill -= n;
+            usb_pacer_steer(&pacer, fill, n);
+        }
+
+        if (settled) {
+            if (start == 0)
+                start = next_rx;
+            sent += n;
+            ppm_sum += usb_pacer_ppm(&pacer);
+            polls++;
+            res.odd_sizes += n < nominal - 1 || n > nominal + 1 + (rate % 1000 != 0);
+            res.min_fill = fill < res.min_fill ? fill : res.min_fill;
+            res.max_fill = fill > res.max_fill ? fill : res.max_fill;
+        }
+        next_rx += rx_period;
+    }
+
+    // Frames per second of the host's own clock against what the
+    // transmitter's clock produced
+    double host_seconds = (next_rx - start) * (1 + rx_ppm * 1e-6);
+    double want = rate * (1 + tx_ppm * 1e-6) / (1 + rx_ppm * 1e-6);
+    res.ppm_error = (sent / host_seconds / want - 1) * 1e6;
+    res.pacer_ppm = (double)ppm_sum / polls;
+    return res;
+}
+
+int main(void)
+{
+    const struct {
+        uint32_t rate;
+        int tx_ppm, rx_ppm;
+        double jitter_ms;
+    } cases[] = {
+        { 48000, 0, 0, 4 },
+        { 48000, 200, 0, 4 },
+        { 48000, -200, 0, 4 },
+        { 48000, 100, -100, 4 },
+        { 48000, 0, 200, 4 },
+        { 48000, -100, 100, 4 },
+        { 48000, 200, -200, 10 },
+        { 44100, 200, 0, 4 },
+        { 44100, -200, 100, 4 },
+    };
+    const double seconds = 3600;
+
+    printf("%.0f s per case, measured after %d s\n", seconds, SETTLE_S);
+    printf(" rate    tx ppm  rx ppm  jitter  fill        rate error ppm  pacer ppm\n");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        sim_result_t r = run(cases[c].rate, cases[c].tx_ppm, cases[c].rx_ppm, seconds, cases[c].jitter_ms);
+        printf("%5u  %+7d  %+6d  %3.0f ms  %4d..%-4d  %+14.3f  %+9.1f\n", cases[c].rate, cases[c].tx_ppm,
+               cases[c].rx_ppm, cases[c].jitter_ms, r.min_fill, r.max_fill, r.ppm_error, r.pacer_ppm);
+
+        CHECK(r.underruns == 0 && r.overruns == 0);
+        CHECK(r.odd_sizes == 0);
+        CHECK(r.min_fill > 0 && r.max_fill < RING_FRAMES - USB_PACER_MAX_FRAMES);
+        CHECK(fabs(r.ppm_error) < 0.05);
+        // On average the correction is the offset between the two clocks
+        double offset = ((1 + cases[c].tx_ppm * 1e-6) / (1 + cases[c].rx_ppm * 1e-6) - 1) * 1e6;
+        CHECK(fabs(r.pacer_ppm - offset) < 1);
+    }
+
+    return host_result("sim_usb_pacer");
+}
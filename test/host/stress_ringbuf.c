@@ -0,0 +1,204 @@
+// Two-thread stress of the SPSC ring family and a writer with two reader
+// threads on ringbuf_bcast, run under ThreadSanitizer. Samples are sequence
+// numbers, so every reader checks what it gets is in order and complete.
+
+#include <pthread.h>
+#include <sched.h>
+#include "host_test.h"
+#include "ringbuf_i16.h"
+#include "ringbuf_bcast.h"
+
+#define SPSC_OPS                2000000     // Per side
+#define BCAST_BLOCKS            400000      // 48 frame writes
+#define BCAST_FRAME             48
+#define BCAST_LAP_EVERY         997         // Writes that ignore a full ring
+
+static ringbuf_i16_t spsc;
+static ringbuf_bcast_t bcast;
+static atomic_int bcast_done;
+
+//--------------------------------------------------------------------+
+// SPSC: reserve/commit, write_buf and write against peek/consume,
+// read_buf and read
+//--------------------------------------------------------------------+
+
+static uint64_t spsc_written;
+
+static void *spsc_producer(void *arg)
+{
+    uint32_t seed = 0x9e3779b9;
+    uint16_t next = 0;
+    int16_t tmp[256];
+
+    for (int op = 0; op < SPSC_OPS; op++) {
+        size_t want = 1 + host_rand_below(&seed, 256), len, n;
+        switch (host_rand_below(&seed, 3)) {
+        case 0: {
+            int16_t *span = ringbuf_i16_reserve(&spsc, want, &len);
+            for (size_t i = 0; i < len; i++)
+                span[i] = next + i;
+            ringbuf_i16_commit(&spsc, len);
+            n = len;
+            break;
+        }
+        case 1:
+            for (size_t i = 0; i < want; i++)
+                tmp[i] = next + i;
+            n = ringbuf_i16_write_buf(&spsc, tmp, want);
+            break;
+        default:
+            n = ringbuf_i16_write(&spsc, next);
+            break;
+        }
+        next += n;
+        spsc_written += n;
+        if (n == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+    uint32_t seed = 0x7f4a7c15;
+    uint16_t next = 0;
+    uint64_t read = 0;
+    int16_t tmp[256];
+    int idle = 0;
+
+    // Runs until the producer is done and the ring is drained
+    for (;;) {
+        size_t want = 1 + host_rand_below(&seed, 256), len, n = 0;
+        switch (host_rand_below(&seed, 3)) {
+        case 0: {
+            const int16_t *span = ringbuf_i16_peek(&spsc, want, &len);
+            for (size_t i = 0; i < len; i++)
+                CHECK((uint16_t)span[i] == (uint16_t)(next + i));
+            ringbuf_i16_consume(&spsc, len);
+            n = len;
+            break;
+        }
+        case 1:
+            n = ringbuf_i16_read_buf(&spsc, tmp, want);
+            for (size_t i = 0; i < n; i++)
+                CHECK((uint16_t)tmp[i] == (uint16_t)(next + i));
+            break;
+        default:
+            if (!ringbuf_i16_empty(&spsc)) {
+                CHECK((uint16_t)ringbuf_i16_read(&spsc) == next);
+                n = 1;
+            }
+            break;
+        }
+        next += n;
+        read += n;
+        if (n == 0) {
+            if (++idle > 100000)
+                break;
+            sched_yield();
+        } else {
+            idle = 0;
+        }
+    }
+    *(uint64_t *)arg = read;
+    return NULL;
+}
+
+//--------------------------------------------------------------------+
+// Broadcast: one writer, a fast and a slow reader
+//--------------------------------------------------------------------+
+
+typedef struct {
+    int reader;
+    int delay;                                  // Spins between reads
+    uint64_t frames;
+    uint32_t resyncs;
+} bcast_reader_arg_t;
+
+static void *bcast_writer(void *arg)
+{
+    audio_sample_t block[BCAST_FRAME * AUDIO_CHANNELS];
+    uint16_t next = 0;
+
+    for (int b = 0; b < BCAST_BLOCKS; b++) {
+        // Mostly wait for the slowest reader, sometimes lap it on purpose
+        while (b % BCAST_LAP_EVERY != 0 && ringbuf_bcast_avail(&bcast) < BCAST_FRAME * AUDIO_CHANNELS)
+            sched_yield();
+        for (int i = 0; i < BCAST_FRAME; i++, next++)
+            for (int c = 0; c < AUDIO_CHANNELS; c++)
+                block[i * AUDIO_CHANNELS + c] = (audio_sample_t)next;
+        ringbuf_bcast_write(&bcast, block, BCAST_FRAME * AUDIO_CHANNELS);
+    }
+    atomic_store(&bcast_done, 1);
+    return NULL;
+}
+
+static void *bcast_reader(void *arg)
+{
+    bcast_reader_arg_t *r = arg;
+    audio_sample_t frames[64 * AUDIO_CHANNELS];
+    uint32_t seed = 0x1234567 + r->reader;
+    uint32_t overruns = 0;
+    bool started = false;
+    uint16_t next = 0;
+
+    while (!atomic_load(&bcast_done) || ringbuf_bcast_size(&bcast, r->reader) > 0) {
+        size_t want = 1 + host_rand_below(&seed, 64);
+        for (volatile int spin = 0; spin < r->delay; spin++)
+            ;
+        if (!ringbuf_bcast_read_frames(&bcast, r->reader, frames, want)) {
+            if (atomic_load(&bcast_done) && ringbuf_bcast_size(&bcast, r->reader) < want * AUDIO_CHANNELS)
+                break;
+            sched_yield();
+            continue;
+        }
+        // After a lap the stream resumes from the newest data
+        if (bcast.readers[r->reader].overruns != overruns) {
+            overruns = bcast.readers[r->reader].overruns;
+            r->resyncs++;
+            started = false;
+        }
+        if (!started)
+            next = (uint16_t)frames[0];
+        started = true;
+        for (size_t i = 0; i < want; i++, next++)
+            for (int c = 0; c < AUDIO_CHANNELS; c++)
+                CHECK((uint16_t)frames[i * AUDIO_CHANNELS + c] == next);
+        r->frames += want;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t prod, cons, writer, readers[2];
+    uint64_t spsc_read = 0;
+
+    ringbuf_i16_reset(&spsc);
+    pthread_create(&cons, NULL, spsc_consumer, &spsc_read);
+    pthread_create(&prod, NULL, spsc_producer, NULL);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    CHECK(spsc_read == spsc_written);
+    printf("spsc: %llu samples, %u refused while full\n",
+           (unsigned long long)spsc_written, ringbuf_i16_overruns(&spsc));
+
+    bcast_reader_arg_t args[2] = { { .delay = 0 }, { .delay = 2000 } };
+    ringbuf_bcast_reset(&bcast);
+    for (int i = 0; i < 2; i++) {
+        args[i].reader = ringbuf_bcast_add_reader(&bcast);
+        ringbuf_bcast_set_active(&bcast, args[i].reader, true);
+    }
+    for (int i = 0; i < 2; i++)
+        pthread_create(&readers[i], NULL, bcast_reader, &args[i]);
+    pthread_create(&writer, NULL, bcast_writer, NULL);
+    pthread_join(writer, NULL);
+    for (int i = 0; i < 2; i++) {
+        pthread_join(readers[i], NULL);
+        printf("bcast reader %d: %llu frames, %u resyncs, %u samples overrun\n", i,
+               (unsigned long long)args[i].frames, args[i].resyncs, bcast.readers[i].overruns);
+        CHECK(args[i].frames > 0);
+    }
+
+    return host_result("stress_ringbuf");
+}
@@ -0,0 +1,5 @@
+// Host build stand-in for the ESP-NOW constants the pure modules use
+#pragma once
+
+#define ESP_NOW_ETH_ALEN        6
+#define ESP_NOW_MAX_DATA_LEN    250
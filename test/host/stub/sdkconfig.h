@@ -0,0 +1,3 @@
+// Host build stand-in for the generated sdkconfig.h. The sample format
+// comes from -DCONFIG_AUDIO_CHANNELS / -DCONFIG_AUDIO_24BIT per target.
+#pragma once
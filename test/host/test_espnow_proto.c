@@ -0,0 +1,145 @@
+// espnow_header_check against an independent statement of the rules, over
+// every combination of version, type, codec, format, channel count and
+// sample rate, frame lengths 0-500 and payload lengths around each valid
+// size, plus every truncation of the header. Each packet ends at the end of
+// a heap block so ASan sees any read past its length.
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "espnow_proto.h"
+#include "adpcm.h"
+#include "lossless.h"
+
+#define HEADER                  sizeof(espnow_data_t)
+#define MAX_FRAME_LEN           500
+
+#define MAX_PACKET              (HEADER + MAX_FRAME_LEN * (ESPNOW_MAX_CHANNELS + 1) * 4 + 1)
+
+static uint8_t *block;
+static uint32_t cases, accepted;
+
+static uint8_t *packet_of(size_t len)
+{
+    return block + MAX_PACKET - len;
+}
+
+static espnow_header_check_t expected(const espnow_data_t *h, size_t payload_len)
+{
+    if (h->version != ESPNOW_VERSION)
+        return ESPNOW_HEADER_VERSION;
+    switch (h->type) {
+    case ESPNOW_PACKET_FEEDBACK:
+        return payload_len == sizeof(espnow_feedback_t) ? ESPNOW_HEADER_OK : ESPNOW_HEADER_PAYLOAD_LEN;
+    case ESPNOW_PACKET_CHANNEL:
+        return payload_len == sizeof(espnow_channel_switch_t) ? ESPNOW_HEADER_OK : ESPNOW_HEADER_PAYLOAD_LEN;
+    case ESPNOW_PACKET_AUDIO:
+    case ESPNOW_PACKET_PARITY:
+        break;
+    default:
+        return ESPNOW_HEADER_TYPE;
+    }
+
+    bool compressed = h->codec == ESPNOW_CODEC_ADPCM || h->codec == ESPNOW_CODEC_LOSSLESS;
+    if (h->codec != ESPNOW_CODEC_PCM && !compressed)
+        return ESPNOW_HEADER_CODEC;
+    if (h->format != ESPNOW_FORMAT_S16 && h->format != ESPNOW_FORMAT_S24_32)
+        return ESPNOW_HEADER_FORMAT;
+    if (h->channels < 1 || h->channels > ESPNOW_MAX_CHANNELS)
+        return ESPNOW_HEADER_CHANNELS;
+    if (compressed && (h->format != ESPNOW_FORMAT_S16 || h->channels != 1))
+        return ESPNOW_HEADER_FORMAT;
+    if (h->sample_rate != 44100 && h->sample_rate != 48000)
+        return ESPNOW_HEADER_SAMPLE_RATE;
+
+    size_t samples = (size_t)h->frame_len * h->channels;
+    if (samples == 0 || samples > ESPNOW_MAX_PACKET_SAMPLES)
+        return ESPNOW_HEADER_FRAME_LEN;
+    if (h->type == ESPNOW_PACKET_PARITY)
+        return ESPNOW_HEADER_OK;
+
+    bool ok;
+    if (h->codec == ESPNOW_CODEC_PCM)
+        ok = payload_len == samples * (h->format == ESPNOW_FORMAT_S24_32 ? 4 : 2);
+    else if (h->codec == ESPNOW_CODEC_ADPCM)
+        ok = payload_len == LOSSLESS_HEADER_LEN + (samples + 1) / 2;   // Same 4-byte header
+    else
+        ok = payload_len >= LOSSLESS_HEADER_LEN && payload_len <= LOSSLESS_HEADER_LEN + samples * 2;
+    return ok ? ESPNOW_HEADER_OK : ESPNOW_HEADER_PAYLOAD_LEN;
+}
+
+static void check(const espnow_data_t *h, size_t payload_len)
+{
+    size_t len = HEADER + payload_len;
+    uint8_t *packet = packet_of(len);
+    memcpy(packet, h, HEADER);
+
+    espnow_header_check_t want = expected(h, payload_len);
+    espnow_header_check_t got = espnow_header_check(packet, len);
+    if (got != want)
+        printf("version %u type %u codec %u format %u channels %u rate %u frame_len %u payload %zu: got %d want %d\n",
+               h->version, h->type, h->codec, h->format, h->channels, h->sample_rate, h->frame_len,
+               payload_len, got, want);
+    CHECK(got == want);
+    cases++;
+    accepted += got == ESPNOW_HEADER_OK;
+}
+
+int main(void)
+{
+    _Static_assert(ADPCM_HEADER_LEN == LOSSLESS_HEADER_LEN, "expected() shares the block header length");
+
+    const uint8_t versions[] = { 0, ESPNOW_VERSION - 1, ESPNOW_VERSION, ESPNOW_VERSION + 1, 0xff };
+    const uint32_t rates[] = { 0, 8000, 44100, 48000, 96000 };
+    espnow_data_t h;
+    memset(&h, 0, sizeof(h));
+    block = malloc(MAX_PACKET);
+    memset(block, 0xa5, MAX_PACKET);
+
+    for (size_t v = 0; v < sizeof(versions); v++)
+    for (h.type = 0; h.type <= ESPNOW_PACKET_CHANNEL + 1; h.type++)
+    for (h.codec = 0; h.codec <= ESPNOW_CODEC_LOSSLESS + 1; h.codec++)
+    for (h.format = 0; h.format <= ESPNOW_FORMAT_S24_32 + 1; h.format++)
+    for (h.channels = 0; h.channels <= ESPNOW_MAX_CHANNELS + 1; h.channels++)
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+    for (h.frame_len = 0; h.frame_len <= MAX_FRAME_LEN; h.frame_len++) {
+        // Other versions are refused on the first byte, a few lengths do
+        if (versions[v] != ESPNOW_VERSION && h.frame_len > 1 && h.frame_len != 48)
+            continue;
+        h.version = versions[v];
+        h.sample_rate = rates[r];
+        size_t samples = (size_t)h.frame_len * (h.channels ? h.channels : 1);
+        const size_t sizes[] = {
+            samples * 2, samples * 4,           // PCM
+            ADPCM_ENCODED_LEN(samples),
+            LOSSLESS_HEADER_LEN, LOSSLESS_MAX_LEN(samples),
+            sizeof(espnow_feedback_t), sizeof(espnow_channel_switch_t),
+        };
+        check(&h, 0);
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            if (sizes[s] > 0)
+                check(&h, sizes[s] - 1);
+            check(&h, sizes[s]);
+            check(&h, sizes[s] + 1);
+        }
+    }
+
+    // Truncated headers: short unless the first byte already gives the
+    // version away
+    h = (espnow_data_t){ .version = ESPNOW_VERSION, .channels = 1, .sample_rate = 48000, .frame_len = 48 };
+    for (size_t len = 0; len < HEADER; len++) {
+        for (int v = 0; v < 2; v++) {
+            h.version = v ? ESPNOW_VERSION : ESPNOW_VERSION + 1;
+            uint8_t *packet = packet_of(len);
+            memcpy(packet, &h, len);
+            espnow_header_check_t got = espnow_header_check(packet, len);
+            CHECK(got == (len >= 1 && !v ? ESPNOW_HEADER_VERSION : ESPNOW_HEADER_SHORT));
+            cases++;
+        }
+    }
+
+    free(block);
+    printf("%u cases, %u accepted\n", cases, accepted);
+    return host_result("test_espnow_proto");
+}
@@ -0,0 +1,237 @@
+// jitter_buffer against directed cases at the classification boundaries
+// and randomised reordered, duplicated and dropped sequences, checking the
+// output order, the LOST deadline and frame ownership.
+
+#include <string.h>
+#include "host_test.h"
+#include "jitter_buffer.h"
+
+#define DEPTH                   3
+
+typedef struct {
+    uint32_t seq;
+    int owned_by_buffer;
+} frame_t;
+
+static uint32_t released;
+
+static void release(void *frame, void *ctx)
+{
+    ((frame_t *)frame)->owned_by_buffer = 0;
+    released++;
+}
+
+static jitter_buffer_insert_t insert(jitter_buffer_t *jb, frame_t *f)
+{
+    jitter_buffer_insert_t r = jitter_buffer_insert(jb, f->seq, f);
+    f->owned_by_buffer = r == JITTER_BUFFER_INSERTED;
+    return r;
+}
+
+// Pops until WAIT; out collects the sequence numbers, lost ones negated - 1
+static int drain(jitter_buffer_t *jb, int64_t *out)
+{
+    int n = 0;
+    void *frame;
+    uint32_t seq;
+    for (;;) {
+        jitter_buffer_pop_t r = jitter_buffer_pop(jb, &frame, &seq);
+        if (r == JITTER_BUFFER_WAIT)
+            return n;
+        if (r == JITTER_BUFFER_FRAME) {
+            CHECK(((frame_t *)frame)->seq == seq);
+            ((frame_t *)frame)->owned_by_buffer = 0;
+            out[n++] = seq;
+        } else {
+            CHECK(frame == NULL);
+            out[n++] = -(int64_t)seq - 1;
+        }
+    }
+}
+
+static void test_directed(uint32_t base)
+{
+    jitter_buffer_t jb;
+    frame_t f[40];
+    int64_t out[40];
+    for (int i = 0; i < 40; i++)
+        f[i] = (frame_t){ .seq = base + i };
+    jitter_buffer_init(&jb, DEPTH, release, NULL);
+    released = 0;
+
+    // In order plays at once
+    CHECK(insert(&jb, &f[0]) == JITTER_BUFFER_INSERTED);
+    CHECK(drain(&jb, out) == 1 && out[0] == base);
+
+    // A gap holds back what is behind it until depth newer frames are in
+    CHECK(insert(&jb, &f[2]) == JITTER_BUFFER_INSERTED);
+    CHECK(drain(&jb, out) == 0);
+    CHECK(insert(&jb, &f[3]) == JITTER_BUFFER_INSERTED);
+    CHECK(drain(&jb, out) == 0);
+    // Still in time: reordered, then everything held plays
+    CHECK(insert(&jb, &f[1]) == JITTER_BUFFER_INSERTED);
+    CHECK(jb.stats.reordered == 1);
+    CHECK(drain(&jb, out) == 3 && out[0] == base + 1 && out[2] == base + 3);
+
+    // The deadline: newest - missing == depth declares it lost
+    CHECK(insert(&jb, &f[5]) == JITTER_BUFFER_INSERTED);
+    CHECK(insert(&jb, &f[6]) == JITTER_BUFFER_INSERTED);
+    CHECK(drain(&jb, out) == 0);                // 6 - 4 < DEPTH
+    CHECK(insert(&jb, &f[7]) == JITTER_BUFFER_INSERTED);
+    CHECK(drain(&jb, out) == 4);                // 7 - 4 == DEPTH
+    CHECK(out[0] == -(int64_t)(base + 4) - 1 && out[1] == base + 5 && out[3] == base + 7);
+    CHECK(jb.stats.lost == 1);
+
+    // After its deadline it is late, the caller keeps it
+    CHECK(insert(&jb, &f[4]) == JITTER_BUFFER_LATE);
+    CHECK(!f[4].owned_by_buffer);
+    // Duplicates: of a held frame, and of one already played
+    CHECK(insert(&jb, &f[9]) == JITTER_BUFFER_INSERTED);
+    frame_t dup = f[9];
+    CHECK(insert(&jb, &dup) == JITTER_BUFFER_DUPLICATE);
+    frame_t old = f[7];
+    CHECK(insert(&jb, &old) == JITTER_BUFFER_LATE);
+    CHECK(jb.stats.duplicate == 1 && jb.stats.late == 2);
+
+    // Classification edges: MAX_DEPTH - 1 ahead is kept, MAX_DEPTH ahead
+    // resynchronises and releases what was held
+    CHECK(drain(&jb, out) == 0);                // 8 is missing, 9 - 8 < DEPTH
+    frame_t far = { .seq = base + 8 + JITTER_BUFFER_MAX_DEPTH - 1 };
+    CHECK(insert(&jb, &far) == JITTER_BUFFER_INSERTED);
+    CHECK(jb.stats.resync == 0);
+    frame_t farther = { .seq = far.seq + 1 };   // Ahead of next_seq 8 by MAX_DEPTH
+    CHECK(insert(&jb, &farther) == JITTER_BUFFER_INSERTED);
+    CHECK(jb.stats.resync == 1);
+    CHECK(released == 2 && !f[9].owned_by_buffer && !far.owned_by_buffer);
+    CHECK(drain(&jb, out) == 1 && out[0] == farther.seq);
+
+    // MAX_DEPTH behind is late, one more resynchronises
+    frame_t behind = { .seq = farther.seq + 1 - JITTER_BUFFER_MAX_DEPTH };
+    CHECK(insert(&jb, &behind) == JITTER_BUFFER_LATE);
+    behind.seq--;
+    CHECK(insert(&jb, &behind) == JITTER_BUFFER_INSERTED);
+    CHECK(jb.stats.resync == 2);
+
+    jitter_buffer_reset(&jb);
+}
+
+// Random channel: drops, duplicates and bounded reordering
+static void test_random(uint32_t base, uint32_t seed, int drop_pct, int dup_pct, int max_delay)
+{
+    enum { N = 200000, MAX_ARRIVALS = N * 2 };
+    static frame_t frames[MAX_ARRIVALS];
+    static uint32_t arrival_at[MAX_ARRIVALS];   // Arrival slot of each copy
+    static int32_t order[MAX_ARRIVALS];
+    static uint32_t newest_before[N];           // Newest seq seen when each first arrived
+    static uint8_t dropped[N], arrived[N], played[N], lost[N];
+    static int64_t out[JITTER_BUFFER_MAX_DEPTH + 1];
+    jitter_buffer_t jb;
+
+    memset(dropped, 0, sizeof(dropped));
+    memset(arrived, 0, sizeof(arrived));
+    memset(played, 0, sizeof(played));
+    memset(lost, 0, sizeof(lost));
+
+    // Each copy gets an arrival time of its send time plus a random delay
+    int copies = 0;
+    // The first frame seen starts the stream, so seq 0 goes first and on time
+    for (uint32_t i = 0; i < N; i++) {
+        if (i > 0 && (int)host_rand_below(&seed, 100) < drop_pct) {
+            dropped[i] = 1;
+            continue;
+        }
+        int n = (int)host_rand_below(&seed, 100) < dup_pct ? 2 : 1;
+        for (int k = 0; k < n; k++) {
+            frames[copies] = (frame_t){ .seq = base + i };
+            arrival_at[copies] = i == 0 ? 0 : i * 4 + host_rand_below(&seed, max_delay * 4 + 1);
+            order[copies] = copies;
+            copies++;
+        }
+    }
+    // Insertion sort by arrival, the data is nearly sorted
+    for (int i = 1; i < copies; i++) {
+        int32_t v = order[i];
+        int j = i - 1;
+        while (j >= 0 && arrival_at[order[j]] > arrival_at[v]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = v;
+    }
+
+    jitter_buffer_init(&jb, DEPTH, release, NULL);
+    released = 0;
+    uint32_t newest = 0, expect = 0, outcomes[3] = { 0 };
+    bool any = false;
+    for (int a = 0; a < copies; a++) {
+        frame_t *f = &frames[order[a]];
+        uint32_t i = f->seq - base;
+        if (!arrived[i])
+            newest_before[i] = newest;
+        arrived[i] = 1;
+        if (!any || (int32_t)(i - newest) > 0)
+            newest = i;
+        any = true;
+
+        outcomes[insert(&jb, f)]++;
+        int n = drain(&jb, out);
+        for (int k = 0; k < n; k++) {
+            uint32_t s = (out[k] >= 0 ? (uint32_t)out[k] : (uint32_t)(-out[k] - 1)) - base;
+            CHECK(s == expect);                 // Strictly consecutive output
+            expect++;
+            if (out[k] >= 0)
+                played[s]++;
+            else
+                lost[s]++;
+        }
+    }
+
+    // Every sequence number up to the newest played out once, as a frame
+    // or as lost; lost means dropped, or first seen after its deadline
+    uint32_t late_arrivals = 0, lost_total = 0;
+    for (uint32_t i = 0; i < expect; i++) {
+        CHECK(played[i] + lost[i] == 1);
+        lost_total += lost[i];
+        if (lost[i] && !dropped[i]) {
+            late_arrivals++;
+            CHECK(!arrived[i] || newest_before[i] - i >= DEPTH);
+        }
+        if (dropped[i])
+            CHECK(lost[i]);
+        else if (played[i] == 0)
+            CHECK(arrived[i]);
+        // A frame that beat its deadline is never lost
+        if (arrived[i] && newest_before[i] < i + DEPTH)
+            CHECK(played[i]);
+    }
+    CHECK(jb.stats.resync == 0);
+    CHECK(jb.stats.lost == lost_total);
+    CHECK(outcomes[JITTER_BUFFER_INSERTED] == jb.stats.inserted);
+    CHECK(outcomes[JITTER_BUFFER_DUPLICATE] == jb.stats.duplicate);
+    CHECK(outcomes[JITTER_BUFFER_LATE] == jb.stats.late);
+
+    // Whatever is still held is released on reset and nothing else is
+    uint32_t held = 0;
+    for (int a = 0; a < copies; a++)
+        held += frames[a].owned_by_buffer;
+    jitter_buffer_reset(&jb);
+    CHECK(released == held);
+    for (int a = 0; a < copies; a++)
+        CHECK(!frames[a].owned_by_buffer);
+
+    printf("drop %d%% dup %d%% delay %d: %u played, %u lost (%u late), %u reordered, %u duplicate\n",
+           drop_pct, dup_pct, max_delay, expect - jb.stats.lost, jb.stats.lost, late_arrivals,
+           jb.stats.reordered, jb.stats.duplicate);
+}
+
+int main(void)
+{
+    test_directed(0);
+    test_directed(0xfffffff8u);                 // Across the sequence wrap
+
+    test_random(0, 0x1, 0, 0, 0);
+    test_random(0xffff0000u, 0x2, 5, 0, 0);
+    test_random(0xffff0000u, 0x3, 2, 5, 2);
+    test_random(0xfffffff0u, 0x4, 10, 10, 6);   // Delays beyond the depth
+    return host_result("test_jitter_buffer");
+}
@@ -0,0 +1,80 @@
+// latency_hist percentiles against the exact order statistic of the same
+// samples: never below it, at most one bucket above it, never above the
+// max, and the max itself once the rank falls in the overflow bucket.
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "latency_hist.h"
+
+#define MAX_SAMPLES             5000
+
+static uint32_t samples[MAX_SAMPLES];
+
+static int compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void check_against_sorted(const latency_hist_t *hist, uint32_t n)
+{
+    qsort(samples, n, sizeof(uint32_t), compare);
+    CHECK(hist->count == n && hist->max_us == samples[n - 1]);
+    for (uint32_t permille = 0; permille <= 1000; permille++) {
+        uint32_t rank = (uint32_t)(((uint64_t)n * permille + 999) / 1000);
+        uint32_t exact = samples[(rank ? rank : 1) - 1];
+        uint32_t got = latency_hist_percentile(hist, permille);
+        CHECK(got >= exact && got <= hist->max_us);
+        if (exact < (LATENCY_HIST_BUCKETS - 1) * LATENCY_HIST_BUCKET_US)
+            CHECK(got - exact <= LATENCY_HIST_BUCKET_US);
+        else
+            CHECK(got == hist->max_us);
+    }
+}
+
+int main(void)
+{
+    latency_hist_t hist;
+
+    latency_hist_reset(&hist);
+    CHECK(latency_hist_percentile(&hist, 500) == 0);
+    latency_hist_add(&hist, 730);
+    CHECK(latency_hist_percentile(&hist, 0) == 730);
+    CHECK(latency_hist_percentile(&hist, 1000) == 730);
+
+    // Bucket edges: 0-99 us reads back as 100, 100 as 200, clamped to the max
+    latency_hist_reset(&hist);
+    latency_hist_add(&hist, 99);
+    latency_hist_add(&hist, 100);
+    latency_hist_add(&hist, 250);
+    CHECK(latency_hist_percentile(&hist, 333) == 100);
+    CHECK(latency_hist_percentile(&hist, 334) == 200);
+    CHECK(latency_hist_percentile(&hist, 1000) == 250);
+
+    // Uniform over 5..5000 us
+    latency_hist_reset(&hist);
+    for (uint32_t i = 0; i < 1000; i++) {
+        samples[i] = (i + 1) * 5;
+        latency_hist_add(&hist, samples[i]);
+    }
+    CHECK(latency_hist_percentile(&hist, 500) == 2600);
+    CHECK(latency_hist_percentile(&hist, 990) == 5000);
+    check_against_sorted(&hist, 1000);
+
+    // Random sizes and ranges, some reaching into the overflow bucket
+    uint32_t seed = 1;
+    for (int run = 0; run < 200; run++) {
+        uint32_t n = 1 + host_rand_below(&seed, MAX_SAMPLES);
+        uint32_t range = 1 + host_rand_below(&seed, 2 * LATENCY_HIST_BUCKETS * LATENCY_HIST_BUCKET_US);
+        latency_hist_reset(&hist);
+        for (uint32_t i = 0; i < n; i++) {
+            samples[i] = host_rand_below(&seed, range);
+            if (host_rand_below(&seed, 100) == 0)
+                samples[i] = host_rand(&seed);  // Rare outliers
+            latency_hist_add(&hist, samples[i]);
+        }
+        check_against_sorted(&hist, n);
+    }
+
+    return host_result("test_latency_hist");
+}
@@ -0,0 +1,166 @@
+// lossless round trips: every block must decode bit exact and never exceed
+// LOSSLESS_MAX_LEN, across signals that favour each predictor order, full
+// scale extremes and block sizes from 1 to UINT16_MAX. Malformed and
+// truncated blocks must be rejected without reading or writing out of
+// bounds, the buffers are exact sized heap copies so ASan sees any overrun.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "lossless.h"
+
+#define RATE                    48000
+#define SIGNAL_LEN              (RATE * 2)
+
+static int16_t signal[SIGNAL_LEN];
+
+typedef void (*make_t)(uint32_t *seed);
+
+static void make_silence(uint32_t *seed) { memset(signal, 0, sizeof(signal)); }
+
+static void make_sine(uint32_t *seed)
+{
+    for (int i = 0; i < SIGNAL_LEN; i++)
+        signal[i] = lrint(0.5 * 32767 * sin(2 * M_PI * 1000.0 * i / RATE));
+}
+
+static void make_mix(uint32_t *seed)
+{
+    for (int i = 0; i < SIGNAL_LEN; i++) {
+        double t = (double)i / RATE;
+        signal[i] = lrint(32767 * (0.3 * sin(2 * M_PI * 220 * t) + 0.2 * sin(2 * M_PI * 1330 * t)
+                                   + 0.1 * sin(2 * M_PI * 4100 * t)));
+    }
+}
+
+static void make_noise(uint32_t *seed)
+{
+    for (int i = 0; i < SIGNAL_LEN; i++)
+        signal[i] = host_rand(seed);
+}
+
+// Full scale square and alternating extremes, the worst residuals for
+// every predictor order
+static void make_extremes(uint32_t *seed)
+{
+    for (int i = 0; i < SIGNAL_LEN; i++) {
+        int phase = (i / 4096) % 3;
+        if (phase == 0)
+            signal[i] = i & 1 ? INT16_MIN : INT16_MAX;
+        else if (phase == 1)
+            signal[i] = (i / 7) & 1 ? INT16_MIN : INT16_MAX;
+        else
+            signal[i] = host_rand_below(seed, 4) == 0 ? INT16_MIN : INT16_MAX;
+    }
+}
+
+// Slow ramps and steps, where order 2 and 3 predict exactly
+static void make_ramp(uint32_t *seed)
+{
+    for (int i = 0; i < SIGNAL_LEN; i++)
+        signal[i] = (int16_t)((i * 3) % 65536 - 32768) + ((i / 1000) & 1 ? 100 : 0);
+}
+
+static size_t round_trip(const int16_t *in, size_t n)
+{
+    uint8_t *coded = malloc(LOSSLESS_MAX_LEN(n));
+    size_t len = lossless_encode(in, n, coded);
+    CHECK(len >= LOSSLESS_HEADER_LEN && len <= LOSSLESS_MAX_LEN(n));
+
+    uint8_t *exact = malloc(len);
+    memcpy(exact, coded, len);
+    int16_t *out = malloc(n * sizeof(int16_t));
+    CHECK(lossless_decode(exact, len, out, n) == n);
+    CHECK(memcmp(in, out, n * sizeof(int16_t)) == 0);
+    // One sample short of room is refused
+    CHECK(lossless_decode(exact, len, out, n - 1) == 0);
+
+    free(out);
+    free(exact);
+    free(coded);
+    return len;
+}
+
+// Every truncation and single bit flips of a valid block
+static void corrupt(const int16_t *in, size_t n, uint32_t *seed)
+{
+    uint8_t *coded = malloc(LOSSLESS_MAX_LEN(n));
+    size_t len = lossless_encode(in, n, coded);
+    int16_t *out = malloc(n * sizeof(int16_t));
+
+    for (size_t cut = 0; cut < len; cut++) {
+        uint8_t *part = malloc(cut ? cut : 1);
+        memcpy(part, coded, cut);
+        size_t got = lossless_decode(part, cut, out, n);
+        CHECK(got == 0);
+        free(part);
+    }
+    uint8_t *flipped = malloc(len);
+    for (int k = 0; k < 200; k++) {
+        memcpy(flipped, coded, len);
+        flipped[host_rand_below(seed, len)] ^= 1 << host_rand_below(seed, 8);
+        CHECK(lossless_decode(flipped, len, out, n) <= n);
+    }
+    free(flipped);
+    free(out);
+    free(coded);
+}
+
+int main(void)
+{
+    const struct {
+        const char *name;
+        make_t make;
+    } signals[] = {
+        { "silence", make_silence },
+        { "sine", make_sine },
+        { "mix", make_mix },
+        { "noise", make_noise },
+        { "extremes", make_extremes },
+        { "ramp", make_ramp },
+    };
+    const size_t blocks[] = { 1, 2, 3, 4, 5, 48, 96, 97, 480, 4096 };
+    uint32_t seed = 1;
+
+    printf("signal    %% of PCM in 96-sample blocks\n");
+    for (size_t s = 0; s < sizeof(signals) / sizeof(signals[0]); s++) {
+        signals[s].make(&seed);
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            size_t n = blocks[b], bytes = 0;
+            for (size_t pos = 0; pos + n <= SIGNAL_LEN; pos += n)
+                bytes += round_trip(&signal[pos], n);
+            if (n == 96)
+                printf("%-8s  %5.1f\n", signals[s].name,
+                       100.0 * bytes / (SIGNAL_LEN / n * n * sizeof(int16_t)));
+        }
+        corrupt(&signal[SIGNAL_LEN / 2], 96, &seed);
+        corrupt(&signal[0], 5, &seed);
+    }
+
+    // The longest block the header can describe
+    static int16_t longest[UINT16_MAX];
+    for (size_t i = 0; i < UINT16_MAX; i++)
+        longest[i] = host_rand_below(&seed, 64) - 32;
+    round_trip(longest, UINT16_MAX);
+
+    // Random bytes never decode out of bounds
+    uint8_t junk[256];
+    int16_t out[512];
+    for (int k = 0; k < 200000; k++) {
+        size_t len = host_rand_below(&seed, sizeof(junk) + 1);
+        for (size_t i = 0; i < len; i++)
+            junk[i] = host_rand(&seed);
+        if (len > 0 && host_rand_below(&seed, 2))
+            junk[0] = host_rand_below(&seed, LOSSLESS_MAX_ORDER + 2);
+        if (len > 1 && host_rand_below(&seed, 2))
+            junk[1] = host_rand_below(&seed, 16);
+        size_t max = host_rand_below(&seed, 512);
+        uint8_t *exact = malloc(len ? len : 1);
+        memcpy(exact, junk, len);
+        CHECK(lossless_decode(exact, len, out, max) <= max);
+        free(exact);
+    }
+
+    return host_result("test_lossless");
+}
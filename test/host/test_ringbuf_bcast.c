@@ -0,0 +1,162 @@
+// ringbuf_bcast with one writer and two readers consuming at different
+// rates, single threaded so every step is deterministic.
+
+#include <string.h>
+#include "host_test.h"
+#include "ringbuf_bcast.h"
+
+#define CH                      AUDIO_CHANNELS
+#define CAP_FRAMES              (RINGBUF_BCAST_CAPACITY / CH)
+#define BLOCK                   48
+
+static ringbuf_bcast_t rb;
+static audio_sample_t src[RINGBUF_BCAST_CAPACITY], dst[RINGBUF_BCAST_CAPACITY];
+static uint32_t seq;                            // Frames written so far
+
+// Frames carry their sequence number in every channel
+static void put(size_t frames)
+{
+    for (size_t i = 0; i < frames; i++)
+        for (int c = 0; c < CH; c++)
+            src[i * CH + c] = (audio_sample_t)(seq + i);
+    ringbuf_bcast_write(&rb, src, frames * CH);
+    seq += frames;
+}
+
+static bool frames_are(const audio_sample_t *buf, size_t frames, uint32_t first)
+{
+    for (size_t i = 0; i < frames * CH; i++)
+        if (buf[i] != (audio_sample_t)(first + i / CH))
+            return false;
+    return true;
+}
+
+static void test_two_rates(void)
+{
+    ringbuf_bcast_reset(&rb);
+    seq = 0;
+    int fast = ringbuf_bcast_add_reader(&rb);
+    int slow = ringbuf_bcast_add_reader(&rb);
+    CHECK(fast == 0 && slow == 1);
+    CHECK(ringbuf_bcast_add_reader(&rb) == -1);
+    ringbuf_bcast_set_active(&rb, fast, true);
+    ringbuf_bcast_set_active(&rb, slow, true);
+
+    // The fast reader keeps up, the slow one takes one block every other
+    // tick and gets lapped; the writer never waits for either
+    uint32_t fast_next = 0, slow_next = 0, slow_lost = 0, slow_frames = 0;
+    for (int tick = 0; tick < 200000; tick++) {
+        put(BLOCK);
+        CHECK(ringbuf_bcast_read_frames(&rb, fast, dst, BLOCK));
+        CHECK(frames_are(dst, BLOCK, fast_next));
+        fast_next += BLOCK;
+
+        if (tick % 2 == 0) {
+            uint32_t behind = seq - slow_next;
+            if (ringbuf_bcast_read_frames(&rb, slow, dst, BLOCK)) {
+                CHECK(behind <= CAP_FRAMES);
+                CHECK(frames_are(dst, BLOCK, slow_next));
+                slow_next += BLOCK;
+                slow_frames += BLOCK;
+            } else {
+                // Lapped: everything not read counts as overrun and the
+                // reader resumes at the newest frame
+                CHECK(behind > CAP_FRAMES);
+                slow_lost += behind;
+                slow_next = seq;
+            }
+        }
+    }
+    CHECK(fast_next == seq);
+    CHECK(rb.readers[fast].overruns == 0);
+    CHECK(rb.readers[fast].underruns == 0);
+    CHECK(slow_lost > 0);
+    CHECK(rb.readers[slow].overruns == slow_lost * CH);
+    CHECK(slow_frames + slow_lost == slow_next);
+    printf("two rates: fast %u frames, slow %u read and %u lapped\n", fast_next, slow_frames, slow_lost);
+}
+
+static void test_inactive_and_skip(void)
+{
+    ringbuf_bcast_reset(&rb);
+    seq = 0;
+    int a = ringbuf_bcast_add_reader(&rb);
+    int b = ringbuf_bcast_add_reader(&rb);
+    ringbuf_bcast_set_active(&rb, a, true);
+
+    // An inactive reader holds nothing back and counts no overruns
+    put(CAP_FRAMES - 10);
+    CHECK(ringbuf_bcast_avail(&rb) == 10 * CH);
+    put(CAP_FRAMES);
+    CHECK(rb.readers[b].overruns == 0);
+
+    // Activating drops what came before
+    ringbuf_bcast_set_active(&rb, b, true);
+    CHECK(ringbuf_bcast_size(&rb, b) == 0);
+    put(BLOCK);
+    CHECK(ringbuf_bcast_read_frames(&rb, b, dst, BLOCK));
+    CHECK(frames_are(dst, BLOCK, seq - BLOCK));
+
+    // Skipping keeps the newest frames for that reader only
+    put(100);
+    CHECK(ringbuf_bcast_skip_to_latest(&rb, b, 10 * CH) == 90 * CH);
+    CHECK(ringbuf_bcast_read_frames(&rb, b, dst, 10));
+    CHECK(frames_are(dst, 10, seq - 10));
+}
+
+// Starts a ring with one active reader whose cursor is offset frames in
+static int start_at(size_t offset)
+{
+    ringbuf_bcast_reset(&rb);
+    seq = 0;
+    int r = ringbuf_bcast_add_reader(&rb);
+    ringbuf_bcast_set_active(&rb, r, true);
+    put(offset);
+    CHECK(offset == 0 || ringbuf_bcast_read_frames(&rb, r, dst, offset));
+    return r;
+}
+
+static void test_every_wrap_offset(void)
+{
+    long cases = 0;
+    for (size_t offset = 0; offset < CAP_FRAMES; offset++) {
+        for (size_t n = 1; n <= 128; n++) {
+            int r = start_at(offset);
+            uint32_t first = seq;
+
+            // One frame short: an underrun for the whole read, nothing consumed
+            put(n - 1);
+            uint32_t underruns = rb.readers[r].underruns;
+            CHECK(!ringbuf_bcast_read_frames(&rb, r, dst, n));
+            CHECK(rb.readers[r].underruns == underruns + n * CH);
+            CHECK(ringbuf_bcast_size(&rb, r) == (n - 1) * CH);
+
+            // The rest arrives in odd pieces, then one exact read across the wrap
+            put(1);
+            put(3);
+            CHECK(ringbuf_bcast_read_frames(&rb, r, dst, n));
+            CHECK(frames_are(dst, n, first));
+            CHECK(ringbuf_bcast_size(&rb, r) == 3 * CH);
+            cases++;
+        }
+
+        // Lapped: fails once, then resumes at the newest frame
+        int r = start_at(offset);
+        put(CAP_FRAMES);
+        put(1);
+        CHECK(!ringbuf_bcast_read_frames(&rb, r, dst, 1));
+        CHECK(ringbuf_bcast_size(&rb, r) == 0);
+        put(1);
+        CHECK(ringbuf_bcast_read_frames(&rb, r, dst, 1));
+        CHECK(frames_are(dst, 1, seq - 1));
+    }
+    printf("every wrap offset: %ld offset and size cases\n", cases);
+}
+
+int main(void)
+{
+    test_two_rates();
+    test_inactive_and_skip();
+    test_every_wrap_offset();
+    return host_result("test_ringbuf_bcast");
+}
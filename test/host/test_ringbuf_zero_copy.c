@@ -0,0 +1,82 @@
+// Randomised reserve/commit and peek/consume on ringbuf_i16, mixed with the
+// copying calls: every sample written comes out once, in order, whatever
+// the wrap offset and the span sizes.
+
+#include "host_test.h"
+#include "ringbuf_i16.h"
+
+#define TEST_OPS                4000000
+
+static ringbuf_i16_t rbuf;
+
+int main(void)
+{
+    uint32_t seed = 0x2545f491;
+    uint16_t next_in = 0, next_out = 0;         // Sequence numbers as samples
+    uint64_t written = 0, read = 0;
+    int16_t tmp[RINGBUF_I16_CAPACITY + 1];
+
+    ringbuf_i16_reset(&rbuf);
+    for (uint32_t op = 0; op < TEST_OPS; op++) {
+        size_t want = 1 + host_rand_below(&seed, RINGBUF_I16_CAPACITY + 1);
+        size_t fill = ringbuf_i16_size(&rbuf);
+        size_t len;
+
+        switch (host_rand_below(&seed, 4)) {
+        case 0: {
+            int16_t *span = ringbuf_i16_reserve(&rbuf, want, &len);
+            size_t start = span - rbuf.buffer;
+            CHECK(len <= want);
+            CHECK(len <= RINGBUF_I16_CAPACITY - fill);
+            CHECK(start + len <= RINGBUF_I16_CAPACITY);
+            // Only short of the request at the wrap or when full
+            CHECK(len == want || start + len == RINGBUF_I16_CAPACITY || len == RINGBUF_I16_CAPACITY - fill);
+            size_t n = len ? host_rand_below(&seed, len + 1) : 0;
+            for (size_t i = 0; i < n; i++)
+                span[i] = next_in++;
+            ringbuf_i16_commit(&rbuf, n);
+            written += n;
+            break;
+        }
+        case 1: {
+            for (size_t i = 0; i < want; i++)
+                tmp[i] = next_in + i;
+            size_t n = ringbuf_i16_write_buf(&rbuf, tmp, want);
+            CHECK(n == (want < RINGBUF_I16_CAPACITY - fill ? want : RINGBUF_I16_CAPACITY - fill));
+            next_in += n;
+            written += n;
+            break;
+        }
+        case 2: {
+            const int16_t *span = ringbuf_i16_peek(&rbuf, want, &len);
+            size_t start = span - rbuf.buffer;
+            CHECK(len <= want && len <= fill);
+            CHECK(start + len <= RINGBUF_I16_CAPACITY);
+            CHECK(len == want || start + len == RINGBUF_I16_CAPACITY || len == fill);
+            size_t n = len ? host_rand_below(&seed, len + 1) : 0;
+            for (size_t i = 0; i < n; i++)
+                CHECK((uint16_t)span[i] == next_out++);
+            ringbuf_i16_consume(&rbuf, n);
+            read += n;
+            break;
+        }
+        default: {
+            size_t n = ringbuf_i16_read_buf(&rbuf, tmp, want);
+            CHECK(n == (want < fill ? want : fill));
+            for (size_t i = 0; i < n; i++)
+                CHECK((uint16_t)tmp[i] == next_out++);
+            read += n;
+            break;
+        }
+        }
+        CHECK(ringbuf_i16_size(&rbuf) == written - read);
+    }
+
+    // Nothing was refused without being counted, nothing left behind
+    size_t left = ringbuf_i16_read_buf(&rbuf, tmp, RINGBUF_I16_CAPACITY);
+    for (size_t i = 0; i < left; i++)
+        CHECK((uint16_t)tmp[i] == next_out++);
+    CHECK(next_out == next_in);
+    printf("%llu samples through the ring\n", (unsigned long long)written);
+    return host_result("test_ringbuf_zero_copy");
+}